@@ -0,0 +1,19 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Barrier.hpp"
+
+Barrier::Barrier(int count) : count(count) {}
+
+void Barrier::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	auto current = generation;
+	if (++waiting == count) {
+		waiting = 0;
+		generation++;
+		allArrived.notify_all();
+	} else {
+		allArrived.wait(lock, [&] { return generation != current; });
+	}
+}
@@ -0,0 +1,26 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef BARRIER_HPP
+#define BARRIER_HPP
+
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief Blocks threads until all of them have called wait()
+ */
+class Barrier {
+private:
+	std::mutex mutex;
+	std::condition_variable allArrived;
+	int count, waiting = 0;
+	unsigned generation = 0;
+
+public:
+	explicit Barrier(int count);
+	void wait();
+};
+
+#endif  // BARRIER_HPP
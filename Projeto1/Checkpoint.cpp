@@ -0,0 +1,341 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Checkpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+const char MAGIC[8] = {'T', 'J', 'C', 'K', 'P', 'T', '0', '6'};
+
+enum Section {
+	ROADWAYS, SEMAPHORES, EVENTS, VEHICLES, WAITERS, SEMAPHORE_WAITERS,
+	SIZES, LIGHTS, SECTIONS
+};
+
+struct Header {
+	char magic[8];
+	std::uint64_t networkKey;
+	std::int32_t time, roadways, semaphores, unused;
+	std::uint64_t eventsProcessed, peakEvents;
+	std::uint64_t offset[SECTIONS], count[SECTIONS];  // Offset in bytes
+};
+
+struct RoadwayRecord {
+	std::int32_t size, in, blocked, out, stopped, nextExit;  // nextExit: -1
+	// Slices of VEHICLES, WAITERS and SIZES
+	std::uint32_t firstVehicle, vehicles, firstWaiter, waiters;
+	std::uint32_t firstSize, sizes;
+	Random random;
+	QueueStatistics statistics;
+};
+
+struct SemaphoreRecord {
+	std::int32_t wakeup;
+	std::uint32_t firstWaiter, waiters;  // Slice of SEMAPHORE_WAITERS
+};
+
+static_assert(std::is_trivially_copyable<RoadwayRecord>::value &&
+	std::is_trivially_copyable<EventRecord>::value &&
+	std::is_trivially_copyable<Vehicle>::value &&
+	std::is_trivially_copyable<Roadway::Waiter>::value &&
+	std::is_trivially_copyable<LightController::State>::value,
+	"checkpoint records are copied as bytes");
+
+const std::size_t SECTION_SIZE[SECTIONS] = {
+	sizeof(RoadwayRecord), sizeof(SemaphoreRecord), sizeof(EventRecord),
+	sizeof(Vehicle), sizeof(Roadway::Waiter), sizeof(int), sizeof(double),
+	sizeof(LightController::State)};
+
+std::uint64_t align(std::uint64_t offset) {
+	return (offset + 7) & ~std::uint64_t(7);
+}
+
+}  // namespace
+
+void Checkpoint::write(const std::string& path, Network& network,
+		std::uint64_t networkKey) const {
+	std::vector<RoadwayRecord> roadways(network.roadwayCount());
+	std::vector<SemaphoreRecord> semaphores(network.semaphoreCount());
+	std::vector<Vehicle> vehicles;
+	std::vector<Roadway::Waiter> waiters;
+	std::vector<int> semaphoreWaiters;
+	std::vector<double> sizes;
+	std::vector<LightController::State> lights;  // By intersection
+
+	Roadway::EntryState entry;
+	Roadway::ExitState exit;
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		const Roadway& r = network.roadway(id);
+		r.save(entry);
+		r.save(exit);
+		RoadwayRecord& record = roadways[id];
+		record.size = entry.size;
+		record.in = entry.in;
+		record.blocked = entry.blocked;
+		record.out = exit.out;
+		record.stopped = exit.stopped;
+		record.nextExit = exit.nextExit != nullptr ? exit.nextExit->id() : -1;
+		record.firstVehicle = vehicles.size();
+		record.vehicles = exit.queue.size();
+		vehicles.insert(vehicles.end(), exit.queue.begin(), exit.queue.end());
+		record.firstWaiter = waiters.size();
+		record.waiters = entry.waiters.size();
+		waiters.insert(waiters.end(), entry.waiters.begin(),
+			entry.waiters.end());
+		record.firstSize = sizes.size();
+		record.sizes = exit.batch.size();
+		sizes.insert(sizes.end(), exit.batch.begin(), exit.batch.end());
+		record.random = exit.random;
+		record.statistics = exit.statistics;
+	}
+	Semaphore::State state;
+	for (int id = 0; id < network.semaphoreCount(); ++id) {
+		network.semaphore(id).save(state);
+		semaphores[id].wakeup = state.wakeup;
+		semaphores[id].firstWaiter = semaphoreWaiters.size();
+		semaphores[id].waiters = state.waiters.size();
+		semaphoreWaiters.insert(semaphoreWaiters.end(), state.waiters.begin(),
+			state.waiters.end());
+	}
+	for (int i = 0; i < network.intersectionCount(); ++i) {
+		lights.push_back(network.lights(i));
+	}
+
+	const void* data[SECTIONS] = {roadways.data(), semaphores.data(),
+		events.data(), vehicles.data(), waiters.data(),
+		semaphoreWaiters.data(), sizes.data(), lights.data()};
+	Header header = {};
+	std::memcpy(header.magic, MAGIC, sizeof MAGIC);
+	header.networkKey = networkKey;
+	header.time = time;
+	header.roadways = network.roadwayCount();
+	header.semaphores = network.semaphoreCount();
+	header.eventsProcessed = eventsProcessed;
+	header.peakEvents = peakEvents;
+	header.count[ROADWAYS] = roadways.size();
+	header.count[SEMAPHORES] = semaphores.size();
+	header.count[EVENTS] = events.size();
+	header.count[VEHICLES] = vehicles.size();
+	header.count[WAITERS] = waiters.size();
+	header.count[SEMAPHORE_WAITERS] = semaphoreWaiters.size();
+	header.count[SIZES] = sizes.size();
+	header.count[LIGHTS] = lights.size();
+	std::uint64_t offset = align(sizeof header);
+	for (int s = 0; s < SECTIONS; ++s) {
+		header.offset[s] = offset;
+		offset = align(offset + header.count[s] * SECTION_SIZE[s]);
+	}
+
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		const char padding[8] = {};
+		out.write(reinterpret_cast<const char*>(&header), sizeof header);
+		std::uint64_t written = sizeof header;
+		for (int s = 0; s < SECTIONS; ++s) {
+			out.write(padding, header.offset[s] - written);
+			std::uint64_t bytes = header.count[s] * SECTION_SIZE[s];
+			out.write(static_cast<const char*>(data[s]), bytes);
+			written = header.offset[s] + bytes;
+		}
+		out.write(padding, offset - written);
+		if (!out.flush()) {
+			throw std::runtime_error("não foi possível escrever " + temporary);
+		}
+	}
+	if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+		throw std::runtime_error("não foi possível escrever " + path);
+	}
+}
+
+void Checkpoint::read(const std::string& path, Network& network,
+		std::uint64_t networkKey) {
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) {
+		throw std::runtime_error("não foi possível abrir " + path);
+	}
+	std::uint64_t bytes = in.tellg();
+	in.seekg(0);
+	// 8-byte words: every record is aligned as if the file were mapped
+	std::vector<std::uint64_t> buffer((bytes + 7) / 8);
+	in.read(reinterpret_cast<char*>(buffer.data()), bytes);
+	const char* file = reinterpret_cast<const char*>(buffer.data());
+
+	Header header;
+	if (!in || bytes < sizeof header) {
+		throw std::runtime_error(path + " não é um checkpoint");
+	}
+	std::memcpy(&header, file, sizeof header);
+	if (std::memcmp(header.magic, MAGIC, sizeof MAGIC) != 0) {
+		throw std::runtime_error(path + " não é um checkpoint");
+	}
+	if (header.networkKey != networkKey ||
+			header.roadways != network.roadwayCount() ||
+			header.semaphores != network.semaphoreCount() ||
+			header.count[ROADWAYS] != std::uint64_t(header.roadways) ||
+			header.count[SEMAPHORES] != std::uint64_t(header.semaphores) ||
+			header.count[LIGHTS] != std::uint64_t(network.intersectionCount())) {
+		throw std::runtime_error(path + " é de outra rede ou frequência");
+	}
+	for (int s = 0; s < SECTIONS; ++s) {
+		if (header.offset[s] % 8 != 0 || header.offset[s] > bytes ||
+				header.count[s] > (bytes - header.offset[s]) / SECTION_SIZE[s]) {
+			throw std::runtime_error(path + " está truncado");
+		}
+	}
+
+	auto roadways = reinterpret_cast<const RoadwayRecord*>(
+		file + header.offset[ROADWAYS]);
+	auto semaphores = reinterpret_cast<const SemaphoreRecord*>(
+		file + header.offset[SEMAPHORES]);
+	auto pending = reinterpret_cast<const EventRecord*>(
+		file + header.offset[EVENTS]);
+	auto vehicles = reinterpret_cast<const Vehicle*>(
+		file + header.offset[VEHICLES]);
+	auto waiters = reinterpret_cast<const Roadway::Waiter*>(
+		file + header.offset[WAITERS]);
+	auto semaphoreWaiters = reinterpret_cast<const int*>(
+		file + header.offset[SEMAPHORE_WAITERS]);
+	auto sizes = reinterpret_cast<const double*>(file + header.offset[SIZES]);
+	auto lights = reinterpret_cast<const LightController::State*>(
+		file + header.offset[LIGHTS]);
+	auto corrupted = [&]() {
+		return std::runtime_error(path + " está corrompido");
+	};
+	auto inside = [&](Section s, std::uint32_t first, std::uint32_t count) {
+		if (first > header.count[s] || count > header.count[s] - first) {
+			throw corrupted();
+		}
+	};
+	auto isRoadway = [&](int id) {
+		return id >= 0 && id < network.roadwayCount();
+	};
+	int exits = 0;
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		exits += network.roadway(id).kind() == Roadway::EXIT;
+	}
+	auto isDestination = [&](int destination) {  // Exit number, or -1
+		return destination >= -1 && destination < exits;
+	};
+
+	// Everything read below indexes the network or a fixed array
+	for (std::uint64_t i = 0; i < header.count[VEHICLES]; ++i) {
+		if (!isDestination(vehicles[i].getDestination())) {
+			throw corrupted();
+		}
+	}
+	for (std::uint64_t i = 0; i < header.count[WAITERS]; ++i) {
+		if (!isRoadway(waiters[i].roadway)) {
+			throw corrupted();
+		}
+	}
+	for (std::uint64_t i = 0; i < header.count[SEMAPHORE_WAITERS]; ++i) {
+		if (!isRoadway(semaphoreWaiters[i])) {
+			throw corrupted();
+		}
+	}
+	for (std::uint64_t i = 0; i < header.count[EVENTS]; ++i) {
+		const EventRecord& e = pending[i];
+		Roadway::Kind kind;
+		switch (e.kind) {
+		case EventKind::SWITCH_PHASE:
+			if (e.target < 0 || e.target >= network.intersectionCount()) {
+				throw corrupted();
+			}
+			continue;
+		case EventKind::CREATE_VEHICLE:
+			kind = Roadway::SOURCE;
+			break;
+		case EventKind::REMOVE_VEHICLE:
+			kind = Roadway::EXIT;
+			break;
+		case EventKind::CHANGE_ROADWAY:
+			if (!isRoadway(e.target)) {
+				throw corrupted();
+			}
+			continue;
+		case EventKind::ARRIVE_VEHICLE:
+		case EventKind::FREE_SPACE:
+			kind = Roadway::CENTRAL;
+			break;
+		default:
+			throw corrupted();
+		}
+		if (!isRoadway(e.target) || network.roadway(e.target).kind() != kind
+				|| !isDestination(int(e.destination) - 1)) {
+			throw corrupted();
+		}
+	}
+
+	Roadway::EntryState entry;
+	Roadway::ExitState exit;
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		const RoadwayRecord& record = roadways[id];
+		inside(VEHICLES, record.firstVehicle, record.vehicles);
+		inside(WAITERS, record.firstWaiter, record.waiters);
+		inside(SIZES, record.firstSize, record.sizes);
+		if (record.sizes > std::uint32_t(Source::SIZE_BATCH) ||
+				record.nextExit < -1 ||
+				record.nextExit >= network.roadwayCount() ||
+				record.stopped < 0 ||
+				std::uint32_t(record.stopped) > record.vehicles ||
+				record.in < 0 || record.out < 0 || record.blocked < 0) {
+			throw corrupted();
+		}
+		entry.size = record.size;
+		entry.in = record.in;
+		entry.blocked = record.blocked;
+		entry.waiters.assign(waiters + record.firstWaiter,
+			waiters + record.firstWaiter + record.waiters);
+		exit.out = record.out;
+		exit.stopped = record.stopped;
+		exit.nextExit = record.nextExit >= 0 ?
+			&network.roadway(record.nextExit) : nullptr;
+		exit.random = record.random;
+		exit.queue.assign(vehicles + record.firstVehicle,
+			vehicles + record.firstVehicle + record.vehicles);
+		exit.batch.assign(sizes + record.firstSize,
+			sizes + record.firstSize + record.sizes);
+		exit.statistics = record.statistics;
+		Roadway& r = network.roadway(id);
+		r.restore(entry);
+		r.restore(exit);
+	}
+	Semaphore::State state;
+	for (int id = 0; id < network.semaphoreCount(); ++id) {
+		const SemaphoreRecord& record = semaphores[id];
+		inside(SEMAPHORE_WAITERS, record.firstWaiter, record.waiters);
+		state.wakeup = record.wakeup;
+		state.waiters.assign(semaphoreWaiters + record.firstWaiter,
+			semaphoreWaiters + record.firstWaiter + record.waiters);
+		network.semaphore(id).restore(state);
+	}
+	for (int i = 0; i < network.intersectionCount(); ++i) {
+		network.lights(i) = lights[i];
+	}
+
+	time = header.time;
+	eventsProcessed = header.eventsProcessed;
+	peakEvents = header.peakEvents;
+	events.assign(pending, pending + header.count[EVENTS]);
+}
+
+std::uint64_t networkKey(const std::string& description, int semaphFrequency) {
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	auto add = [&](unsigned char byte) {
+		hash = (hash ^ byte) * 0x100000001b3ULL;
+	};
+	for (char c : description) {
+		add(c);
+	}
+	for (int i = 0; i < 4; ++i) {
+		add(semaphFrequency >> (8 * i));
+	}
+	return hash;
+}
@@ -0,0 +1,61 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Event.hpp"
+#include "Network.hpp"
+
+/**
+ * @brief Whole state of a simulation at some time, kept in a binary file
+ *
+ * The state is what the engines save and restore anyway (see Roadway,
+ * Semaphore and LightController), plus the pending events. The file is
+ * a fixed header followed by flat arrays of plain records, each at an
+ * 8-byte aligned offset given in the header: one record per roadway
+ * and per semaphore, then the events, vehicles, waiters and drawn
+ * vehicle sizes they point into, and the lights of each intersection.
+ * So it is read with a single read() (or could be mapped as is), with
+ * no parsing. Numbers are in the machine's byte order: checkpoints
+ * move between runs, not between machines.
+ */
+struct Checkpoint {
+	int time = 0;  // Every event up to time has run
+	std::uint64_t eventsProcessed = 0;
+	std::size_t peakEvents = 0;
+	std::vector<EventRecord> events;  // Pending
+
+	/**
+	 * @brief Writes the checkpoint and the state of network to path
+	 *
+	 * Writes to path + ".tmp" first and renames it, so a crash never
+	 * leaves a half-written checkpoint behind.
+	 *
+	 * @param networkKey Identifies the network (see networkKey())
+	 * @throws std::runtime_error if the file can't be written
+	 */
+	void write(const std::string& path, Network& network,
+		std::uint64_t networkKey) const;
+
+	/**
+	 * @brief Reads a checkpoint from path into this and network
+	 *
+	 * @throws std::runtime_error if the file can't be read, is not a
+	 *         checkpoint or was written for another network
+	 */
+	void read(const std::string& path, Network& network,
+		std::uint64_t networkKey);
+};
+
+/**
+ * @brief Hash (FNV-1a) of a network description and light frequency
+ */
+std::uint64_t networkKey(const std::string& description, int semaphFrequency);
+
+#endif  // CHECKPOINT_HPP
@@ -5,6 +5,25 @@
 #include "Event.hpp"
 #include <iostream>
 
+void EventSink::push(const EventRecord& e) {
+	if (size_ == CAPACITY) {
+		throw std::out_of_range("EventSink full");
+	}
+	events[size_++] = e;
+}
+
+int EventSink::size() const {
+	return size_;
+}
+
+const EventRecord& EventSink::operator[](int i) const {
+	return events[i];
+}
+
+void EventSink::clear() {
+	size_ = 0;
+}
+
 bool Event::operator>(const Event& e) const {
 	return time > e.time;
 }
@@ -55,10 +74,14 @@ bool Event::operator<=(int i) const {
 
 Event::Event(int t) : time(t) {}
 
-DoublyLinkedList<Event*> Event::run() {
+void Event::run(EventSink&) {
 	throw std::logic_error("Event::run can not be called");
 }
 
+EventRecord Event::record() const {
+	throw std::logic_error("Event::record can not be called");
+}
+
 int Event::getTime() const {
 	return time;
 }
@@ -67,6 +90,13 @@ void Event::print() {
 	printf("Evento Geral.\n");
 }
 
+SwitchPhaseEv::SwitchPhaseEv(int t, Network& network, int intersection) :
+	Event(t), network(network), intersection(intersection) {}
+
+void SwitchPhaseEv::print() {
+	printf("SwitchPhaseEv (%d s).\n", getTime());
+}
+
 CreateVehicleEv::CreateVehicleEv(int t, Source& source_) :
 	Event(t), source(source_) {}
 	
@@ -81,82 +111,228 @@ void RemoveVehicleEv::print() {
 	printf("RemoveVehicleEv (%d s).\n", getTime());
 }
 
-ChangeRoadwayEv::ChangeRoadwayEv(int t, Roadway& p_) :
-	Event(t), roadway(p_) {}
+ChangeRoadwayEv::ChangeRoadwayEv(int t, Roadway& p_, bool woken) :
+	Event(t), roadway(p_), woken(woken) {}
 
 void ChangeRoadwayEv::print() {
 	printf("ChangeRoadwayEv (%d s).\n", getTime());
 }
 
-OpenSemaphoreEv::OpenSemaphoreEv(int t, Semaphore& s, int f) :
-	Event(t), semaphore(s), frequency(f) {}
+ArriveVehicleEv::ArriveVehicleEv(int t, CentralRoadway& r, int entry,
+		int size, int destination) :
+	Event(t), roadway(r), entry(entry), size(size), destination(destination) {}
 
-void OpenSemaphoreEv::print() {
-	printf("OpenSemaphoreEv (%d s).\n", getTime());
+void ArriveVehicleEv::print() {
+	printf("ArriveVehicleEv (%d s).\n", getTime());
 }
 
-DoublyLinkedList<Event*> CreateVehicleEv::run() {
-	bool worked = true;
+FreeSpaceEv::FreeSpaceEv(int t, CentralRoadway& r, int size) :
+	Event(t), roadway(r), size(size) {}
 
-	try {
-		source.createVehicle();
-	} catch (std::runtime_error& err) {
-		worked = false;
-	}
+void FreeSpaceEv::print() {
+	printf("FreeSpaceEv (%d s).\n", getTime());
+}
 
-	DoublyLinkedList<Event*> newEvents;
+EventRecord SwitchPhaseEv::record() const {
+	return {getTime(), intersection, 0, EventKind::SWITCH_PHASE, 0, 0};
+}
 
-	if (worked) {
-		int nextEventsTime = source.nextEventsTime(getTime());
+EventRecord CreateVehicleEv::record() const {
+	return {getTime(), source.id(), 0, EventKind::CREATE_VEHICLE, 0, 0};
+}
 
-		newEvents.push_back(new CreateVehicleEv(nextEventsTime, source));
+EventRecord RemoveVehicleEv::record() const {
+	return {getTime(), exitRoadway.id(), 0, EventKind::REMOVE_VEHICLE, 0, 0};
+}
 
-		newEvents.push_back(new ChangeRoadwayEv(nextEventsTime+source.timeToTravel(), source));
-	} else {
-		newEvents.push_back(new CreateVehicleEv(getTime()+5, source));
+EventRecord ChangeRoadwayEv::record() const {
+	return {getTime(), roadway.id(), woken, EventKind::CHANGE_ROADWAY, 0, 0};
+}
+
+EventRecord ArriveVehicleEv::record() const {
+	return {getTime(), roadway.id(), entry, EventKind::ARRIVE_VEHICLE,
+		std::uint8_t(size), std::uint16_t(destination + 1)};
+}
+
+EventRecord FreeSpaceEv::record() const {
+	return {getTime(), roadway.id(), 0, EventKind::FREE_SPACE,
+		std::uint8_t(size), 0};
+}
+
+void SwitchPhaseEv::run(EventSink& sink) {
+	handle(getTime(), network, intersection, sink);
+}
+
+void CreateVehicleEv::run(EventSink& sink) {
+	handle(getTime(), source, sink);
+}
+
+void RemoveVehicleEv::run(EventSink& sink) {
+	handle(getTime(), exitRoadway, sink);
+}
+
+void ChangeRoadwayEv::run(EventSink& sink) {
+	handle(getTime(), roadway, woken, sink);
+}
+
+void ArriveVehicleEv::run(EventSink& sink) {
+	auto vehicle = Vehicle::withSize(size);
+	vehicle.setDestination(destination);
+	handle(getTime(), roadway, vehicle, sink);
+}
+
+void FreeSpaceEv::run(EventSink& sink) {
+	handle(getTime(), roadway, size, sink);
+}
+
+// The first roadway waiting for space on roadway, if it fits now, tries
+// again; a source waiting for its own space tries to create the vehicle
+static void wakeWaiter(int t, Roadway& roadway, EventSink& sink) {
+	int waiter = roadway.wakeWaiter();
+	if (waiter == roadway.id()) {
+		sink.push({t, waiter, 0, EventKind::CREATE_VEHICLE, 0, 0});
+	} else if (waiter >= 0) {
+		sink.push({t, waiter, 1, EventKind::CHANGE_ROADWAY, 0, 0});
 	}
+}
+
+// The first roadway waiting for the green tries again, now or when the
+// light turns green
+static void wakeWaiter(int t, Semaphore& semaphore, EventSink& sink) {
+	int when;
+	int waiter = semaphore.wakeWaiter(t, when);
+	if (waiter >= 0) {
+		sink.push({when, waiter, 1, EventKind::CHANGE_ROADWAY, 0, 0});
+	}
+}
 
-	return newEvents;
+EventOutcome SwitchPhaseEv::handle(int, Network& network,
+		int intersection, EventSink& sink) {
+	auto& lights = network.lights(intersection);
+	network.controller(intersection)->decide(network, intersection, lights);
+	sink.push({lights.end, intersection, 0, EventKind::SWITCH_PHASE, 0, 0});
+	return EventOutcome::DONE;
 }
 
-DoublyLinkedList<Event*> RemoveVehicleEv::run() {
-	exitRoadway.pop();
+EventOutcome CreateVehicleEv::handle(int t, Source& source,
+		EventSink& sink) {
+	if (source.tryCreateVehicle(t)) {
+		int nextEventsTime = source.nextEventsTime(t);
 
-	DoublyLinkedList<Event*> newEvents;
+		sink.push({nextEventsTime, source.id(), 0, EventKind::CREATE_VEHICLE,
+			0, 0});
 
-	return newEvents;
+		sink.push({nextEventsTime+source.timeToTravel(), source.id(), 0,
+			EventKind::CHANGE_ROADWAY, 0, 0});
+		return EventOutcome::DONE;
+	}
+	// Arrivals stop until the next vehicle to leave makes room
+	source.wait(source.id(), source.nextVehicleSize());
+	return EventOutcome::FULL;
+}
+
+EventOutcome RemoveVehicleEv::handle(int t, ExitRoadway& exitRoadway,
+		EventSink& sink) {
+	exitRoadway.pop(t);
+	wakeWaiter(t, exitRoadway, sink);
+	return EventOutcome::DONE;
 }
 
-DoublyLinkedList<Event*> ChangeRoadwayEv::run() {
-	DoublyLinkedList<Event*> newEvents;
+EventOutcome ChangeRoadwayEv::handle(int t, Roadway& roadway, bool woken,
+		EventSink& sink) {
+	// Behind a stopped vehicle, wait for it to go
+	if (!woken) {
+		roadway.stop();
+		if (roadway.stopped() > 1) {
+			return EventOutcome::BEHIND;
+		}
+	}
 
 	Roadway* nextRoadway;
+	Vehicle vehicle;
+	auto status = roadway.tryMove(t, nextRoadway, vehicle);
+	int vehicleSize = vehicle.getSize();
+	if (status != Roadway::DONE) {
+		if (status == Roadway::RED_LIGHT) {
+			roadway.getSemaphore().wait(roadway.id());
+		} else {
+			nextRoadway->wait(roadway.id(), vehicleSize);
+		}
+		// Others at the same light need not wait for this one
+		wakeWaiter(t, roadway.getSemaphore(), sink);
+		return status == Roadway::RED_LIGHT ? EventOutcome::RED_LIGHT :
+			EventOutcome::FULL;
+	}
 
-	// Try to move vehicle, if not possible creates new event 5s later
-	try {
-		nextRoadway = &(roadway.moveVehicle());
-	} catch (std::runtime_error& err) {
-		//newEvents.push_back(new ChangeRoadwayEv(getTime()+5, roadway));
-		return newEvents;
+	// The space left on a central roadway gets back to its entrance later
+	if (roadway.kind() == Roadway::CENTRAL) {
+		sink.push({t+roadway.timeToTravel(), roadway.id(), 0,
+			EventKind::FREE_SPACE, std::uint8_t(vehicleSize), 0});
+	} else {
+		wakeWaiter(t, roadway, sink);
 	}
 
 	// Check if nextRoadway is an ExitRoadway
-	if (ExitRoadway* s = dynamic_cast<ExitRoadway*>(nextRoadway)) {
-		newEvents.push_back(new RemoveVehicleEv(getTime()+s->timeToTravel(), *s));
+	if (nextRoadway->kind() == Roadway::EXIT) {
+		sink.push({t+nextRoadway->timeToTravel(), nextRoadway->id(), 0,
+			EventKind::REMOVE_VEHICLE, 0, 0});
+	} else if (nextRoadway->kind() == Roadway::CENTRAL) {
+		sink.push({t+nextRoadway->timeToTravel(), nextRoadway->id(),
+			nextRoadway->entered(), EventKind::ARRIVE_VEHICLE,
+			std::uint8_t(vehicleSize),
+			std::uint16_t(vehicle.getDestination() + 1)});
 	} else {
-		newEvents.push_back(new ChangeRoadwayEv(getTime()+nextRoadway->timeToTravel(), *nextRoadway));
+		sink.push({t+nextRoadway->timeToTravel(), nextRoadway->id(), 0,
+			EventKind::CHANGE_ROADWAY, 0, 0});
 	}
+	wakeWaiter(t, *nextRoadway, sink);
 
-	return newEvents;
-
+	// The next vehicle stopped here takes its turn at the light
+	if (roadway.stopped() > 0) {
+		roadway.getSemaphore().wait(roadway.id());
+	}
+	wakeWaiter(t, roadway.getSemaphore(), sink);
+	return EventOutcome::DONE;
 }
 
-DoublyLinkedList<Event*> OpenSemaphoreEv::run() {
-	semaphore.nextState();
-
-	DoublyLinkedList<Event*> newEvents;
+EventOutcome ArriveVehicleEv::handle(int t, CentralRoadway& roadway,
+		const Vehicle& vehicle, EventSink& sink) {
+	roadway.arrive(vehicle, t);
+	return ChangeRoadwayEv::handle(t, roadway, false, sink);
+}
 
-	newEvents.push_back(new OpenSemaphoreEv(getTime()+frequency, semaphore, frequency));
+EventOutcome FreeSpaceEv::handle(int t, CentralRoadway& roadway, int size,
+		EventSink& sink) {
+	roadway.release(size);
+	wakeWaiter(t, roadway, sink);
+	return EventOutcome::DONE;
+}
 
-	return newEvents;
-}
\ No newline at end of file
+EventOutcome dispatch(const EventRecord& e, Network& network,
+		EventSink& sink) {
+	switch (e.kind) {
+	case EventKind::SWITCH_PHASE:
+		return SwitchPhaseEv::handle(e.time, network, e.target, sink);
+	case EventKind::CREATE_VEHICLE:
+		return CreateVehicleEv::handle(e.time,
+			static_cast<Source&>(network.roadway(e.target)), sink);
+	case EventKind::REMOVE_VEHICLE:
+		return RemoveVehicleEv::handle(e.time,
+			static_cast<ExitRoadway&>(network.roadway(e.target)), sink);
+	case EventKind::CHANGE_ROADWAY:
+		return ChangeRoadwayEv::handle(e.time, network.roadway(e.target),
+			e.arg != 0, sink);
+	case EventKind::ARRIVE_VEHICLE: {
+		auto vehicle = Vehicle::withSize(e.size);
+		vehicle.setDestination(e.destination - 1);
+		return ArriveVehicleEv::handle(e.time,
+			static_cast<CentralRoadway&>(network.roadway(e.target)), vehicle,
+			sink);
+	}
+	case EventKind::FREE_SPACE:
+		return FreeSpaceEv::handle(e.time,
+			static_cast<CentralRoadway&>(network.roadway(e.target)), e.size,
+			sink);
+	}
+	return EventOutcome::DONE;  // Unknown kind: nothing to do
+}
@@ -5,14 +5,102 @@
 #ifndef EVENT_HPP
 #define EVENT_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include "Network.hpp"
 #include "Roadway.hpp"
 #include "Semaphore.hpp"
 #include "Vehicle.hpp"
-#include "doubly_linked_list.h"
+
+/**
+ * @brief Kind tag of an EventRecord
+*/
+enum class EventKind : std::uint8_t {
+	SWITCH_PHASE,    // target: intersection; first, so the lights change
+	                 // before the vehicles of that second move
+	CREATE_VEHICLE,  // target: Source roadway
+	REMOVE_VEHICLE,  // target: ExitRoadway
+	CHANGE_ROADWAY,  // target: Roadway, arg: 1 if woken up, 0 if arriving
+	ARRIVE_VEHICLE,  // target: CentralRoadway, arg: entry number, size,
+	                 // destination
+	FREE_SPACE       // target: CentralRoadway, size
+};
+
+/**
+ * @brief What running an event did (see Trace)
+*/
+enum class EventOutcome : std::uint8_t {
+	DONE,       // Did what it was for
+	FULL,       // No space: the vehicle waits (source or next roadway)
+	RED_LIGHT,  // The vehicle waits for the green
+	BEHIND      // The vehicle stopped behind others at the light
+};
+
+/**
+ * @brief Compact (16 bytes) plain representation of an event
+ *
+ * This is what the schedulers store. Roadways and intersections are
+ * referred to by their id in the Network.
+*/
+struct EventRecord {
+	int time;  // time the event will run
+	int target;  // roadway or intersection id
+	int arg;  // extra argument, depends on kind
+	EventKind kind;
+	std::uint8_t size;  // vehicle size, depends on kind
+	std::uint16_t destination;  // vehicle's exit number + 1 (0: none)
+};
+
+/**
+ * @brief Order of events that run at the same time
+ *
+ * Depends only on the event (kind, target, arg), never on when it was
+ * scheduled, so any run of the same events (sequential or partitioned,
+ * see ParallelEngine) handles them in the same order.
+*/
+inline std::uint64_t tieBreak(const EventRecord& e) {
+	return std::uint64_t(e.kind) << 60 |
+		std::uint64_t(e.target & 0x0fffffff) << 32 | std::uint32_t(e.arg);
+}
+
+/**
+ * @brief Fixed-capacity buffer that receives the events created by an event
+ *
+ * No event creates more than CAPACITY follow-up events, so the buffer
+ * lives inline (on the stack of the main loop) and never allocates.
+*/
+class EventSink {
+public:
+	static const int CAPACITY = 4;
+
+	void push(const EventRecord& e);
+	int size() const;
+	const EventRecord& operator[](int i) const;
+	void clear();
+
+private:
+	EventRecord events[CAPACITY];
+	int size_ = 0;
+};
+
+/**
+ * @brief Runs an event: switches on its kind and calls the event's handler
+ *
+ * @param e Event to be run
+ * @param network Maps the event's target id to its Roadway or
+ *        intersection
+ * @param sink Receives the new events to be inserted in main Events List
+ * @return What the event did
+*/
+EventOutcome dispatch(const EventRecord& e, Network& network,
+	EventSink& sink);
 
 /**
  * @brief Base class for all Events
+ *
+ * Convenience layer over EventRecord: each subclass holds references to
+ * its objects and converts to a record with record().
 */
 class Event {
 private:
@@ -26,9 +114,10 @@ public:
 	/**
 	 * @brief Run Event
 	 * 
-	 * @return List of new events to be inserted in main Events List
+	 * @param sink Receives the new events to be inserted in main Events List
 	*/
-	virtual DoublyLinkedList<Event*> run();
+	virtual void run(EventSink& sink);
+	virtual EventRecord record() const;
 	int getTime() const;
 
 	// Overloading operators
@@ -47,6 +136,27 @@ public:
 	bool operator <=(int i) const;
 };
 
+/**
+ * @brief Event to let the controller of an adaptive intersection pick
+ * its next phase (see LightController)
+ *
+ * Vehicles waiting for a green there try again at each decision (see
+ * Semaphore::wakeWaiter), so the event wakes no one up.
+ */
+class SwitchPhaseEv : public Event {
+private:
+	Network& network;
+	int intersection;
+public:
+	SwitchPhaseEv(int t, Network& network, int intersection);
+	static EventOutcome handle(int t, Network& network, int intersection,
+		EventSink& sink);
+	void run(EventSink& sink);
+	EventRecord record() const;
+	void print();
+
+};
+
 /**
  * @brief Event to Create a Vehicle in a Source Roadway
 */
@@ -55,8 +165,11 @@ private:
 	Source& source;
 public:
 	CreateVehicleEv(int t, Source& source_);
-	DoublyLinkedList<Event*> run();
+	static EventOutcome handle(int t, Source& source, EventSink& sink);
+	void run(EventSink& sink);
+	EventRecord record() const;
 	void print();
+
 };
 
 /**
@@ -67,33 +180,70 @@ private:
 	ExitRoadway& exitRoadway;
 public:
 	RemoveVehicleEv(int t, ExitRoadway& exitRoadway_);
-	DoublyLinkedList<Event*> run();
+	static EventOutcome handle(int t, ExitRoadway& exitRoadway,
+		EventSink& sink);
+	void run(EventSink& sink);
+	EventRecord record() const;
 	void print();
+
 };
 
 /**
  * @brief Event to change a vehicle's roadway, when it gets to a semaphore
+ *
+ * A vehicle arriving behind others that are stopped waits for them. A
+ * roadway that can't move its first vehicle joins a waiter list (see
+ * Roadway), and is woken up with this event: at once by the event that
+ * gives the space back, or at the next green (see Semaphore::wakeWaiter).
  */
 class ChangeRoadwayEv : public Event {
 private:
 	Roadway& roadway;
+	bool woken;
 public:
-	ChangeRoadwayEv(int t, Roadway& p_);
-	DoublyLinkedList<Event*> run();
+	ChangeRoadwayEv(int t, Roadway& p_, bool woken = false);
+	static EventOutcome handle(int t, Roadway& roadway, bool woken,
+		EventSink& sink);
+	void run(EventSink& sink);
+	EventRecord record() const;
 	void print();
+
 };
 
 /**
- * @brief Event to change a semaphore's state
+ * @brief Event to put a vehicle in the queue of a central roadway, when it
+ * gets to the semaphore; then tries to change its roadway
  */
-class OpenSemaphoreEv : public Event {
+class ArriveVehicleEv : public Event {
 private:
-	Semaphore& semaphore;
-	int frequency;
+	CentralRoadway& roadway;
+	int entry, size, destination;
 public:
-	OpenSemaphoreEv(int t, Semaphore& s, int f);
-	DoublyLinkedList<Event*> run();
+	ArriveVehicleEv(int t, CentralRoadway& r, int entry, int size,
+		int destination = -1);
+	static EventOutcome handle(int t, CentralRoadway& roadway,
+		const Vehicle& vehicle, EventSink& sink);
+	void run(EventSink& sink);
+	EventRecord record() const;
 	void print();
+
+};
+
+/**
+ * @brief Event to give the space a vehicle left back to a central roadway
+ */
+class FreeSpaceEv : public Event {
+private:
+	CentralRoadway& roadway;
+	int size;
+public:
+	FreeSpaceEv(int t, CentralRoadway& r, int size);
+	static EventOutcome handle(int t, CentralRoadway& roadway, int size,
+		EventSink& sink);
+	void run(EventSink& sink);
+	EventRecord record() const;
+	void print();
+
 };
 
 #endif // EVENT_HPP
\ No newline at end of file
@@ -0,0 +1,82 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Grid.hpp"
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Approaches, named after where vehicles come from, in phase order
+const char APPROACH[] = {'w', 's', 'e', 'n'};
+const int DR[] = {0, 1, 0, -1};  // Row step towards each side
+const int DC[] = {-1, 0, 1, 0};  // Column step towards each side
+
+std::string intersection(int r, int c) {
+	return "I" + std::to_string(r) + "_" + std::to_string(c);
+}
+
+}  // namespace
+
+std::string gridNetwork(int rows, int cols, int green) {
+	if (rows < 1 || cols < 1) {
+		throw std::invalid_argument("gridNetwork: empty grid");
+	}
+
+	auto inside = [&](int r, int c) {
+		return r >= 0 && r < rows && c >= 0 && c < cols;
+	};
+	// Roadway arriving at (r, c) from side a
+	auto incoming = [&](int r, int c, int a) {
+		int nr = r + DR[a], nc = c + DC[a];
+		return (inside(nr, nc) ? "C" : "F") + intersection(r, c) + APPROACH[a];
+	};
+	// Roadway leaving (r, c) towards side a: the neighbour's incoming
+	// roadway, or an exit on the border
+	auto outgoing = [&](int r, int c, int a) {
+		int nr = r + DR[a], nc = c + DC[a];
+		if (inside(nr, nc)) {
+			return incoming(nr, nc, (a + 2) % 4);
+		}
+		return "X" + intersection(r, c) + APPROACH[a];
+	};
+
+	std::ostringstream out;
+	out << "# " << rows << "x" << cols << " grid\n";
+	for (int r = 0; r < rows; ++r) {
+		for (int c = 0; c < cols; ++c) {
+			out << "intersection " << intersection(r, c) << " " << green
+				<< " w s e n\n";
+		}
+	}
+
+	for (int r = 0; r < rows; ++r) {
+		for (int c = 0; c < cols; ++c) {
+			std::string name = intersection(r, c);
+			for (int a = 0; a < 4; ++a) {
+				std::string semaphore = name + "." + APPROACH[a];
+
+				// Coming from side a, a vehicle goes straight to the
+				// opposite side; right and left depend on the heading
+				int straight = (a + 2) % 4;
+				int right = (a + 1) % 4;
+				int left = (a + 3) % 4;
+				std::string exits = outgoing(r, c, right) + " " +
+					outgoing(r, c, straight) + " " + outgoing(r, c, left);
+
+				int nr = r + DR[a], nc = c + DC[a];
+				if (inside(nr, nc)) {
+					out << "central " << incoming(r, c, a) << " " << semaphore
+						<< " 300 60 " << exits << " 0.1 0.9\n";
+				} else {
+					out << "source " << incoming(r, c, a) << " " << semaphore
+						<< " 500 60 20 5 " << exits << " 0.1 0.9\n";
+					out << "exit X" << name << APPROACH[a] << " " << semaphore
+						<< " 500 60\n";
+				}
+			}
+		}
+	}
+	return out.str();
+}
@@ -0,0 +1,24 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef GRID_HPP
+#define GRID_HPP
+
+#include <string>
+
+/**
+ * @brief Writes the description (see Network) of a rows x cols grid
+ *
+ * Intersection (r, c) is named I<r>_<c> and has the approaches w, s, e
+ * and n, opened in this order. Neighbour intersections are joined by
+ * central roadways; on the border, every approach is a Source and every
+ * way out is an ExitRoadway.
+ *
+ * @param rows Intersections from north to south
+ * @param cols Intersections from west to east
+ * @param green Seconds between light changes (0: command line frequency)
+ */
+std::string gridNetwork(int rows, int cols, int green = 0);
+
+#endif  // GRID_HPP
@@ -0,0 +1,107 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "LightController.hpp"
+#include <stdexcept>
+#include "Network.hpp"
+
+std::unique_ptr<LightController> LightController::make(
+		const Settings& settings) {
+	switch (settings.policy) {
+	case ACTUATED:
+		return std::unique_ptr<LightController>(
+			new ActuatedController(settings.threshold, settings.extension));
+	case MAX_PRESSURE:
+		return std::unique_ptr<LightController>(new MaxPressureController());
+	default:
+		return nullptr;
+	}
+}
+
+ActuatedController::ActuatedController(int threshold, int extension) :
+	threshold(threshold),
+	extension(extension) {
+	if (threshold < 0 || extension < 1) {
+		throw std::runtime_error("controle atuado com limiar negativo ou "
+			"extensão menor que 1 s");
+	}
+}
+
+void ActuatedController::decide(const Network& network, int intersection,
+		State& state) const {
+	auto& i = network.intersection(intersection);
+	auto& phases = network.plan(intersection).phases();
+	int time = state.end;
+	auto& phase = phases[state.phase];
+	if (time + extension - state.start <= 2 * phase.duration) {
+		for (int k = 0; k < i.semaphoreCount; ++k) {
+			if (phase.opens(k) &&
+					network.queue(i.firstSemaphore + k) > threshold) {
+				state.end = time + extension;
+				return;
+			}
+		}
+	}
+	state.phase = (state.phase + 1) % phases.size();
+	state.start = time;
+	state.end = time + phases[state.phase].duration;
+}
+
+void MaxPressureController::decide(const Network& network, int intersection,
+		State& state) const {
+	auto& i = network.intersection(intersection);
+	auto& phases = network.plan(intersection).phases();
+	// Average vehicle, to count the vehicles on a roadway from its space
+	const double vehicleSize = Vehicle::SIZE_ + Vehicle::SIZE_VAR / 2.0;
+
+	double pressure[PhasePlan::MAX_APPROACHES];
+	for (int k = 0; k < i.semaphoreCount && k < PhasePlan::MAX_APPROACHES;
+			++k) {
+		pressure[k] = 0;
+		for (int id : network.controlledBy(i.firstSemaphore + k)) {
+			const Roadway& r = network.roadway(id);
+			if (r.stuck()) {
+				continue;  // A green would not move it
+			}
+			Roadway* exits[3];
+			double chances[3];
+			r.exitsOf(exits);
+			r.exitChances(chances);
+			pressure[k] += r.stopped();
+			for (int e = 0; e < 3; ++e) {
+				if (exits[e] != nullptr) {
+					pressure[k] -= chances[e] *
+						(exits[e]->capacity() - exits[e]->space()) / vehicleSize;
+				}
+			}
+		}
+	}
+
+	auto sum = [&](const PhasePlan::Phase& phase) {
+		double total = 0;
+		for (int k = 0; k < i.semaphoreCount &&
+				k < PhasePlan::MAX_APPROACHES; ++k) {
+			if (phase.opens(k)) {
+				total += pressure[k];
+			}
+		}
+		return total;
+	};
+	int best = state.phase;
+	double most = sum(phases[best]);
+	for (auto p = 0u; p < phases.size(); ++p) {
+		double pressureOf = sum(phases[p]);
+		if (pressureOf > most) {
+			best = p;
+			most = pressureOf;
+		}
+	}
+
+	int time = state.end;
+	if (best != state.phase) {
+		state.phase = best;
+		state.start = time;
+	}
+	state.end = time + phases[best].duration;
+}
@@ -0,0 +1,88 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef LIGHT_CONTROLLER_HPP
+#define LIGHT_CONTROLLER_HPP
+
+#include <memory>
+
+class Network;
+
+/**
+ * @brief Picks, as the simulation goes, the phase an intersection runs
+ *
+ * A fixed-time intersection has no controller: its lights come from the
+ * time alone (see PhasePlan). An adaptive one runs the phase in its
+ * State until the next decision, a SWITCH_PHASE event at State::end,
+ * when the controller looks at the queues of the approaches and picks
+ * the phase and the time of the decision after it. The duration of each
+ * phase in the plan is its minimum green.
+ *
+ * A decision only looks at the intersection's own approaches (vehicles
+ * stopped at the light, space left on the roadways ahead), so its cost
+ * doesn't grow with the network, and partitions (see Partitioning) only
+ * read what they own.
+ */
+class LightController {
+public:
+	enum Policy { FIXED, ACTUATED, MAX_PRESSURE };
+
+	struct Settings {  // Of an intersection
+		Policy policy = FIXED;
+		int threshold = 2;  // ACTUATED: more vehicles than this keep the green
+		int extension = 5;  // ACTUATED: seconds of green added each time
+	};
+
+	struct State {  // Phase running since start, until the decision at end
+		int phase, start, end;
+	};
+
+	/**
+	 * @return The controller of the policy; nullptr for FIXED
+	 * @throws std::runtime_error on invalid settings
+	 */
+	static std::unique_ptr<LightController> make(const Settings& settings);
+
+	virtual ~LightController() {}
+
+	/**
+	 * @brief Decides, at time state.end, what runs next
+	 *
+	 * Sets the phase and the time of the next decision (> time); keeps
+	 * start if the phase goes on.
+	 */
+	virtual void decide(const Network& network, int intersection,
+		State& state) const = 0;
+};
+
+/**
+ * @brief Goes through the phases in order, but keeps the green while
+ * more than threshold vehicles wait on a green approach, extension
+ * seconds at a time, up to twice the phase's duration
+ */
+class ActuatedController : public LightController {
+private:
+	int threshold, extension;
+
+public:
+	ActuatedController(int threshold, int extension);
+	void decide(const Network& network, int intersection,
+		State& state) const;
+};
+
+/**
+ * @brief Runs the phase with the largest pressure: vehicles stopped on
+ * its green approaches, less the vehicles already on the roadways they
+ * turn into, weighted by how often they turn there
+ *
+ * A roadway whose first vehicle waits for space ahead adds nothing, as
+ * a green would not move it. A tie keeps the running phase.
+ */
+class MaxPressureController : public LightController {
+public:
+	void decide(const Network& network, int intersection,
+		State& state) const;
+};
+
+#endif  // LIGHT_CONTROLLER_HPP
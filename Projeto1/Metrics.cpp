@@ -0,0 +1,97 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Metrics.hpp"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "Statistics.hpp"
+
+MetricsExporter::MetricsExporter(const std::string& path,
+		const Network& network) :
+	network(network),
+	path(path),
+	started(std::chrono::steady_clock::now()),
+	lastWall(started) {
+	if (!std::ofstream(path + ".tmp")) {
+		throw std::runtime_error("não foi possível escrever " + path);
+	}
+	std::remove((path + ".tmp").c_str());
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		names.push_back(network.name(id));
+	}
+	for (auto& b : buffers) {
+		b.in.reserve(names.size());
+	}
+	thread = std::thread(&MetricsExporter::work, this);
+}
+
+MetricsExporter::~MetricsExporter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void MetricsExporter::publish(int time, std::uint64_t events,
+		std::size_t pending, bool last) {
+	if (!last && !wanted.load(std::memory_order_relaxed)) {
+		return;
+	}
+	wanted.store(false, std::memory_order_relaxed);
+	Snapshot& s = buffers[back];
+	s.time = time;
+	s.events = events;
+	s.pending = pending;
+	s.wall = std::chrono::steady_clock::now();
+	s.in.clear();
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		s.in.push_back(network.roadway(id).areIn());
+	}
+	back = middle.exchange(back | FRESH) & ~FRESH;
+}
+
+void MetricsExporter::work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping) {
+		wake.wait_for(lock, std::chrono::milliseconds(PERIOD_MS));
+		write();
+	}
+	write();  // The loop has stopped: the last one
+}
+
+void MetricsExporter::write() {
+	if ((middle.load() & FRESH) == 0) {
+		return;
+	}
+	front = middle.exchange(front) & ~FRESH;
+	const Snapshot& s = buffers[front];
+	wanted.store(true, std::memory_order_relaxed);
+
+	using Seconds = std::chrono::duration<double>;
+	double wall = Seconds(s.wall - started).count();
+	double elapsed = Seconds(s.wall - lastWall).count();
+	double rate = elapsed > 0 ? (s.events - lastEvents) / elapsed : 0;
+	lastEvents = s.events;
+	lastWall = s.wall;
+
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary);
+		out << "{\"time\": " << s.time << ", \"wall_seconds\": " << wall
+			<< ", \"events\": " << s.events << ", \"events_per_second\": "
+			<< rate << ", \"pending\": " << s.pending << ",\n \"in\": {";
+		for (auto id = 0u; id < s.in.size(); ++id) {
+			out << (id > 0 ? ", " : "") << quoted(names[id]) << ": "
+				<< s.in[id];
+		}
+		out << "}}\n";
+		if (!out) {
+			return;  // Maybe next time; the run goes on
+		}
+	}
+	std::rename(temporary.c_str(), path.c_str());
+}
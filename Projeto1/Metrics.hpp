@@ -0,0 +1,95 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Network.hpp"
+
+/**
+ * @brief Shows a running simulation from outside: a background thread
+ * keeps a file with its latest snapshot
+ *
+ * The event loop publishes a snapshot every so many simulated seconds,
+ * never waiting for the thread: it copies the counters into a buffer and
+ * swaps it with one atomic exchange (triple buffering). The vehicles on
+ * each roadway are only copied when the thread has taken the previous
+ * snapshot and asked for a new one, about once per wall second; the
+ * other publishes cost one atomic load. The thread writes each snapshot
+ * to <path>.tmp and renames it over path, so readers always find a
+ * whole one. The file is JSON:
+ *
+ *   {"time": <simulated s>, "wall_seconds": ..., "events": ...,
+ *    "events_per_second": <since the last write>, "pending": ...,
+ *    "in": {"<roadway>": <areIn()>, ...}}
+ */
+class MetricsExporter {
+public:
+	struct Snapshot {
+		int time = -1;  // -1: none yet
+		std::uint64_t events = 0;
+		std::size_t pending = 0;
+		std::chrono::steady_clock::time_point wall;
+		std::vector<int> in;  // areIn(), by roadway id
+	};
+
+	static const int PERIOD_MS = 1000;  // Between two writes
+
+private:
+	static const int FRESH = 4;  // In middle: published, not taken yet
+
+	const Network& network;
+	std::string path;
+	std::vector<std::string> names;  // Of the roadways
+	Snapshot buffers[3];
+	int back = 0, front = 1;  // Of the loop, of the thread
+	std::atomic<int> middle{2};  // Index of the third, | FRESH
+	std::atomic<bool> wanted{true};  // The thread waits for a snapshot
+	std::chrono::steady_clock::time_point started;
+	std::uint64_t lastEvents = 0;
+	std::chrono::steady_clock::time_point lastWall;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::thread thread;
+
+	void work();
+	void write();  // The newest snapshot, if not written yet
+
+public:
+	/**
+	 * @brief Starts the thread; nothing is written before the first
+	 * publish()
+	 */
+	MetricsExporter(const std::string& path, const Network& network);
+
+	/**
+	 * @brief Stops the thread, after writing the last snapshot
+	 */
+	~MetricsExporter();
+
+	MetricsExporter(const MetricsExporter&) = delete;
+	MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+	/**
+	 * @brief Copies the counters as they are at time, if the thread
+	 * wants a snapshot (from the loop's thread only)
+	 *
+	 * @param last The run's last snapshot: copied anyway
+	 */
+	void publish(int time, std::uint64_t events, std::size_t pending,
+		bool last = false);
+};
+
+#endif  // METRICS_HPP
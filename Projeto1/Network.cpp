@@ -0,0 +1,651 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Network.hpp"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+
+const char* const Network::TWO_INTERSECTIONS =
+	"# Two intersections joined by the central roadways\n"
+	"intersection S1 0 w s e n\n"
+	"intersection S2 0 w s e n\n"
+	"\n"
+	"exit    O1oeste S1.e 2000 80\n"
+	"exit    N1norte S1.s  500 60\n"
+	"exit    S1sul   S1.n  500 60\n"
+	"exit    L1leste S2.w  400 30\n"
+	"exit    N2norte S2.s  500 40\n"
+	"exit    S2sul   S1.n  500 40\n"
+	"\n"
+	"central C1oeste S1.e 300 60 N1norte O1oeste S1sul   0.3 0.7\n"
+	"central C1leste S2.w 300 60 S2sul   L1leste N2norte 0.3 0.7\n"
+	"\n"
+	"source  O1leste S1.w 2000 80 10  2 S1sul   C1leste N1norte 0.1 0.9\n"
+	"source  N1sul   S1.n  500 60 20  5 O1oeste S1sul   C1leste 0.1 0.9\n"
+	"source  S1norte S1.s  500 60 30  7 C1leste N1norte O1oeste 0.1 0.9\n"
+	"source  L1oeste S2.e  400 30 10  2 N2norte C1oeste S2sul   0.3 0.7\n"
+	"source  N2sul   S2.n  500 40 20  5 C1oeste S2sul   L1leste 0.3 0.7\n"
+	"source  S2norte S2.s  500 40 60 15 L1leste N2norte C1oeste 0.3 0.7\n";
+
+const std::uint8_t Network::UNREACHABLE;
+
+void Network::reserve(int semaphores, int sources, int centrals, int exits) {
+	if (!roadways.empty() || !this->semaphores.empty()) {
+		throw std::logic_error("Network::reserve after adding items");
+	}
+	this->semaphores.reserve(semaphores);
+	this->sources.reserve(sources);
+	this->centrals.reserve(centrals);
+	this->exits.reserve(exits);
+	roadways.reserve(sources + centrals + exits);
+}
+
+template<typename T>
+void Network::checkCapacity(const std::vector<T>& v) const {
+	if (v.size() == v.capacity()) {
+		throw std::length_error("Network: capacity reserved is exhausted");
+	}
+}
+
+void Network::checkRoadway(int size, int velocity) {
+	if (size <= 0) {
+		throw std::runtime_error("tamanho deve ser positivo");
+	}
+	if (velocity <= 0) {
+		throw std::runtime_error("velocidade deve ser positiva");
+	}
+	if (size * 3.6 / velocity > INT_MAX / 2) {  // See timeToTravel
+		throw std::runtime_error("pista longa demais para a velocidade");
+	}
+}
+
+void Network::add(Roadway* r, const std::string& name) {
+	if (!roadwayIds.emplace(name, roadways.size()).second) {
+		throw std::runtime_error("Roadway " + name + " declared twice");
+	}
+	r->setId(roadways.size());
+	roadways.push_back(r);
+	names.push_back(name);
+}
+
+int Network::addIntersection(const std::string& name, int green,
+		const std::vector<std::string>& approaches) {
+	Intersection i{name, semaphoreCount(), int(approaches.size()), green, {},
+		{}};
+	if (green < 0) {
+		throw std::runtime_error("verde inválido " + std::to_string(green));
+	}
+	if (!intersectionIds.emplace(name, intersections.size()).second) {
+		throw std::runtime_error("Intersection " + name + " declared twice");
+	}
+
+	for (auto k = 0u; k < approaches.size(); ++k) {
+		checkCapacity(semaphores);
+		std::string semaphoreName = name + "." + approaches[k];
+		if (!semaphoreIds.emplace(semaphoreName, semaphores.size()).second) {
+			throw std::runtime_error("Semaphore " + semaphoreName + " declared twice");
+		}
+		semaphores.emplace_back();
+		semaphores.back().setId(semaphores.size() - 1);
+		semaphoreNames.push_back(semaphoreName);
+	}
+
+	intersections.push_back(i);
+	return intersections.size() - 1;
+}
+
+void Network::setPhases(int intersection,
+		const std::vector<PhasePlan::Phase>& phases) {
+	intersections[intersection].phases = phases;
+}
+
+void Network::setControl(int intersection,
+		const LightController::Settings& control) {
+	intersections[intersection].control = control;
+}
+
+void Network::addDemand(const Demand& demand) {
+	if (roadways.at(demand.source)->kind() != Roadway::SOURCE ||
+			roadways.at(demand.exit)->kind() != Roadway::EXIT) {
+		throw std::logic_error("Network::addDemand: not a source and an exit");
+	}
+	demands.push_back(demand);
+}
+
+void Network::planLights(int defaultGreen) {
+	plans.clear();
+	controllers.clear();
+	// Semaphores point into them
+	plans.reserve(intersections.size());
+	lights_.assign(intersections.size(), LightController::State{0, 0, 0});
+	for (auto& i : intersections) {
+		try {
+			if (i.phases.empty()) {
+				int green = i.green > 0 ? i.green : defaultGreen;
+				plans.push_back(PhasePlan::alternating(i.semaphoreCount, green));
+			} else {
+				plans.emplace_back(i.phases);
+			}
+			controllers.push_back(LightController::make(i.control));
+		} catch (std::runtime_error& err) {
+			throw std::runtime_error("cruzamento " + i.name + ": " +
+				err.what());
+		}
+		LightController::State* lights = nullptr;
+		if (controllers.back() != nullptr) {
+			lights = &lights_[plans.size() - 1];
+			lights->end = plans.back().phases()[0].duration;
+		}
+		for (int k = 0; k < i.semaphoreCount; ++k) {
+			semaphores[i.firstSemaphore + k].setPlan(&plans.back(), k, lights);
+		}
+	}
+
+	controlled.assign(semaphores.size(), {});
+	for (auto r : roadways) {
+		if (r->kind() != Roadway::EXIT) {
+			controlled[r->getSemaphore().id()].push_back(r->id());
+		}
+	}
+}
+
+void Network::planRoutes() {
+	routes.clear();
+	for (auto r : roadways) {
+		r->setRoutes(nullptr);
+	}
+	for (auto& s : sources) {
+		s.clearDemand();
+	}
+	if (demands.empty()) {
+		return;
+	}
+	// Exit numbers + 1 must fit in 16 bits (see Vehicle)
+	if (exits.size() >= 0xffff) {
+		throw std::runtime_error("saídas demais para as tabelas de rotas");
+	}
+
+	int n = roadways.size(), destinations = exits.size();
+	std::vector<std::vector<int>> feeders(n);  // Roadways that lead to one
+	for (auto r : roadways) {
+		Roadway* next[3];
+		r->exitsOf(next);
+		for (auto e : next) {
+			if (e != nullptr) {
+				feeders[e->id()].push_back(r->id());
+			}
+		}
+	}
+
+	routes.assign(std::size_t(n) * destinations, UNREACHABLE);
+	std::vector<int> time(n);  // From the end of a roadway to the exit
+	typedef std::pair<int, int> Entry;  // Time, roadway
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	for (int x = 0; x < destinations; ++x) {
+		std::fill(time.begin(), time.end(), INT_MAX);
+		time[exits[x].id()] = 0;
+		open.push(Entry(0, exits[x].id()));
+		while (!open.empty()) {
+			Entry top = open.top();
+			open.pop();
+			if (top.first > time[top.second]) {
+				continue;  // Already reached faster
+			}
+			int through = top.first + roadways[top.second]->timeToTravel();
+			for (int feeder : feeders[top.second]) {
+				if (through < time[feeder]) {
+					time[feeder] = through;
+					open.push(Entry(through, feeder));
+				}
+			}
+		}
+
+		// First exit slot on a fastest route; ties go right, straight, left
+		for (int id = 0; id < n; ++id) {
+			Roadway* next[3];
+			roadways[id]->exitsOf(next);
+			int best = INT_MAX;
+			for (int slot = 0; slot < 3; ++slot) {
+				Roadway* e = next[slot];
+				if (e == nullptr || time[e->id()] == INT_MAX) {
+					continue;
+				}
+				int via = time[e->id()] + e->timeToTravel();
+				if (via < best) {
+					best = via;
+					routes[std::size_t(id) * destinations + x] = slot;
+				}
+			}
+		}
+	}
+	for (int id = 0; id < n; ++id) {
+		if (roadways[id]->kind() != Roadway::EXIT) {
+			roadways[id]->setRoutes(&routes[std::size_t(id) * destinations]);
+		}
+	}
+
+	for (auto& d : demands) {
+		int x = exitNumber(d.exit);
+		if (routes[std::size_t(d.source) * destinations + x] == UNREACHABLE) {
+			if (d.required) {
+				throw std::runtime_error("saída " + names[d.exit] +
+					" inalcançável a partir de " + names[d.source]);
+			}
+			continue;
+		}
+		static_cast<Source*>(roadways[d.source])->addDemand(x, d.weight);
+	}
+}
+
+ExitRoadway& Network::addExit(const std::string& name, Semaphore& semaphore,
+		int size, int velocity) {
+	checkCapacity(exits);
+	checkRoadway(size, velocity);
+	exits.emplace_back(semaphore, size, velocity);
+	add(&exits.back(), name);
+	return exits.back();
+}
+
+CentralRoadway& Network::addCentral(const std::string& name,
+		Semaphore& semaphore, int size, int velocity, double probLeft,
+		double probRight) {
+	checkCapacity(centrals);
+	checkRoadway(size, velocity);
+	centrals.emplace_back(semaphore, size, velocity, probLeft, probRight);
+	add(&centrals.back(), name);
+	return centrals.back();
+}
+
+Source& Network::addSource(const std::string& name, Semaphore& semaphore,
+		int size, int velocity, int fixedFrequency, int variableFrequency,
+		double probLeft, double probRight) {
+	checkCapacity(sources);
+	checkRoadway(size, velocity);
+	// Vehicles come every fixed +- variable seconds
+	if (variableFrequency < 0 || fixedFrequency < 1 ||
+			fixedFrequency < variableFrequency) {
+		throw std::runtime_error("frequências inválidas");
+	}
+	sources.emplace_back(semaphore, size, velocity, fixedFrequency,
+		variableFrequency, probLeft, probRight);
+	add(&sources.back(), name);
+	return sources.back();
+}
+
+void Network::load(std::istream& in) {
+	struct Line {
+		int number;
+		std::vector<std::string> words;
+	};
+	std::vector<Line> lines;
+	int semaphoreTotal = 0, sourceTotal = 0, centralTotal = 0, exitTotal = 0;
+
+	// First pass: split lines in words and count items of each kind
+	std::string text;
+	for (int number = 1; std::getline(in, text); ++number) {
+		auto comment = text.find('#');
+		if (comment != std::string::npos) {
+			text.erase(comment);
+		}
+		std::istringstream words(text);
+		Line line{number, {}};
+		for (std::string w; words >> w; ) {
+			line.words.push_back(w);
+		}
+		if (line.words.empty()) {
+			continue;
+		}
+
+		const std::string& kind = line.words[0];
+		std::size_t expected = line.words.size();
+		if (kind == "intersection") {
+			expected = std::max<std::size_t>(expected, 4);
+			semaphoreTotal += line.words.size() - 3;
+		} else if (kind == "phases") {
+			expected = std::max<std::size_t>(expected, 3);
+		} else if (kind == "control") {
+			expected = line.words.size() == 5 ? 5 : 3;
+		} else if (kind == "exit") {
+			expected = 5;
+			exitTotal++;
+		} else if (kind == "central") {
+			expected = 10;
+			centralTotal++;
+		} else if (kind == "source") {
+			expected = 12;
+			sourceTotal++;
+		} else if (kind == "demand") {
+			expected = 4;
+		} else {
+			throw std::runtime_error("linha " + std::to_string(number) +
+				": tipo desconhecido '" + kind + "'");
+		}
+		if (line.words.size() != expected) {
+			throw std::runtime_error("linha " + std::to_string(number) +
+				": número de campos inválido para '" + kind + "'");
+		}
+		lines.push_back(line);
+	}
+
+	reserve(semaphoreTotal, sourceTotal, centralTotal, exitTotal);
+
+	auto error = [](const Line& line, const std::string& what) {
+		return std::runtime_error("linha " + std::to_string(line.number) +
+			": " + what);
+	};
+	auto integer = [&](const Line& line, int i) {
+		try {
+			return std::stoi(line.words[i]);
+		} catch (std::exception&) {
+			throw error(line, "número inválido '" + line.words[i] + "'");
+		}
+	};
+	auto real = [&](const Line& line, int i) {
+		try {
+			return std::stod(line.words[i]);
+		} catch (std::exception&) {
+			throw error(line, "número inválido '" + line.words[i] + "'");
+		}
+	};
+	auto semaphoreOf = [&](const Line& line) -> Semaphore& {
+		auto it = semaphoreIds.find(line.words[2]);
+		if (it == semaphoreIds.end()) {
+			throw error(line, "semáforo desconhecido '" + line.words[2] + "'");
+		}
+		return semaphores[it->second];
+	};
+	auto intersectionOf = [&](const Line& line) {
+		auto it = intersectionIds.find(line.words[1]);
+		if (it == intersectionIds.end()) {
+			throw error(line, "cruzamento desconhecido '" + line.words[1] +
+				"'");
+		}
+		return it->second;
+	};
+	// <seconds>:<approach>+<approach>..., or <seconds>:- (all red)
+	auto phasesOf = [&](const Line& line) {
+		const Intersection& i = intersections[intersectionOf(line)];
+		std::vector<PhasePlan::Phase> phases;
+		for (auto w = 2u; w < line.words.size(); ++w) {
+			const std::string& word = line.words[w];
+			auto colon = word.find(':');
+			if (colon == std::string::npos) {
+				throw error(line, "fase inválida '" + word + "'");
+			}
+			PhasePlan::Phase phase{0, 0};
+			try {
+				phase.duration = std::stoi(word.substr(0, colon));
+			} catch (std::exception&) {
+				phase.duration = 0;
+			}
+			if (phase.duration < 1) {
+				throw error(line, "fase inválida '" + word + "'");
+			}
+			std::string green = word.substr(colon + 1);
+			if (green != "-") {
+				std::istringstream names(green);
+				for (std::string name; std::getline(names, name, '+'); ) {
+					auto it = semaphoreIds.find(i.name + "." + name);
+					int k = it == semaphoreIds.end() ? -1 :
+						it->second - i.firstSemaphore;
+					if (k < 0 || k >= i.semaphoreCount ||
+							k >= PhasePlan::MAX_APPROACHES) {
+						throw error(line, "aproximação inválida '" + name +
+							"'");
+					}
+					phase.green |= std::uint32_t(1) << k;
+				}
+			}
+			phases.push_back(phase);
+		}
+		return phases;
+	};
+	// fixed | max-pressure | actuated [<threshold> <extension>]
+	auto controlOf = [&](const Line& line) {
+		LightController::Settings control;
+		const std::string& policy = line.words[2];
+		if (policy == "actuated") {
+			control.policy = LightController::ACTUATED;
+			if (line.words.size() == 5) {
+				control.threshold = integer(line, 3);
+				control.extension = integer(line, 4);
+			}
+		} else if (policy == "max-pressure" && line.words.size() == 3) {
+			control.policy = LightController::MAX_PRESSURE;
+		} else if (policy != "fixed" || line.words.size() != 3) {
+			throw error(line, "controle inválido '" + policy + "'");
+		}
+		return control;
+	};
+	auto roadwayOf = [&](const Line& line, int i) {
+		auto it = roadwayIds.find(line.words[i]);
+		if (it == roadwayIds.end()) {
+			throw error(line, "pista desconhecida '" + line.words[i] + "'");
+		}
+		return roadways[it->second];
+	};
+
+	// Second pass: semaphores, their phases and control, then roadways;
+	// errors of the add functions get the number of the line
+	const Line* current = nullptr;
+	try {
+		LightController::Settings defaultControl;
+		for (auto& line : lines) {
+			current = &line;
+			if (line.words[0] == "intersection") {
+				std::vector<std::string> approaches(line.words.begin() + 3,
+					line.words.end());
+				addIntersection(line.words[1], integer(line, 2), approaches);
+			} else if (line.words[0] == "control" && line.words[1] == "*") {
+				defaultControl = controlOf(line);
+			}
+		}
+		for (int i = 0; i < intersectionCount(); ++i) {
+			setControl(i, defaultControl);
+		}
+		for (auto& line : lines) {
+			current = &line;
+			if (line.words[0] == "phases") {
+				setPhases(intersectionOf(line), phasesOf(line));
+			} else if (line.words[0] == "control" && line.words[1] != "*") {
+				setControl(intersectionOf(line), controlOf(line));
+			}
+		}
+		for (auto& line : lines) {
+			current = &line;
+			const std::string& kind = line.words[0];
+			if (kind == "exit") {
+				addExit(line.words[1], semaphoreOf(line),
+					integer(line, 3), integer(line, 4));
+			} else if (kind == "central") {
+				addCentral(line.words[1], semaphoreOf(line),
+					integer(line, 3), integer(line, 4),
+					real(line, 8), real(line, 9));
+			} else if (kind == "source") {
+				addSource(line.words[1], semaphoreOf(line),
+					integer(line, 3), integer(line, 4),
+					integer(line, 5), integer(line, 6),
+					real(line, 10), real(line, 11));
+			}
+		}
+	} catch (std::runtime_error& err) {
+		if (std::string(err.what()).compare(0, 6, "linha ") == 0) {
+			throw;
+		}
+		throw error(*current, err.what());
+	}
+
+	// Third pass: connect roadways to their exits
+	for (auto& line : lines) {
+		const std::string& kind = line.words[0];
+		int first = kind == "central" ? 5 : kind == "source" ? 7 : 0;
+		if (first > 0) {
+			roadway(line.words[1]).setExits(roadwayOf(line, first),
+				roadwayOf(line, first + 1), roadwayOf(line, first + 2));
+		}
+	}
+
+	// Last: demand between sources and exits, '*' for all of a kind
+	auto endsOf = [&](const Line& line, int i, Roadway::Kind kind) {
+		std::vector<int> ids;
+		for (auto r : roadways) {
+			if (r->kind() == kind && line.words[i] == "*") {
+				ids.push_back(r->id());
+			}
+		}
+		if (line.words[i] != "*") {
+			Roadway* r = roadwayOf(line, i);
+			if (r->kind() != kind) {
+				throw error(line, "'" + line.words[i] + "' não é " +
+					(kind == Roadway::SOURCE ? "fonte" : "saída"));
+			}
+			ids.push_back(r->id());
+		}
+		return ids;
+	};
+	for (auto& line : lines) {
+		if (line.words[0] != "demand") {
+			continue;
+		}
+		double weight = real(line, 3);
+		if (!(weight > 0)) {
+			throw error(line, "peso inválido '" + line.words[3] + "'");
+		}
+		bool required = line.words[1] != "*" && line.words[2] != "*";
+		for (int source : endsOf(line, 1, Roadway::SOURCE)) {
+			for (int exit : endsOf(line, 2, Roadway::EXIT)) {
+				addDemand({source, exit, weight, required});
+			}
+		}
+	}
+}
+
+Roadway& Network::roadway(int id) const {
+	return *roadways[id];
+}
+
+Roadway& Network::roadway(const std::string& name) const {
+	auto it = roadwayIds.find(name);
+	if (it == roadwayIds.end()) {
+		throw std::out_of_range("Unknown roadway " + name);
+	}
+	return *roadways[it->second];
+}
+
+const std::string& Network::name(int id) const {
+	return names[id];
+}
+
+Semaphore& Network::semaphore(int id) {
+	return semaphores[id];
+}
+
+Semaphore& Network::semaphore(const std::string& name) {
+	auto it = semaphoreIds.find(name);
+	if (it == semaphoreIds.end()) {
+		throw std::out_of_range("Unknown semaphore " + name);
+	}
+	return semaphore(it->second);
+}
+
+const std::string& Network::semaphoreName(int id) const {
+	return semaphoreNames[id];
+}
+
+const Network::Intersection& Network::intersection(int i) const {
+	return intersections[i];
+}
+
+const PhasePlan& Network::plan(int intersection) const {
+	return plans[intersection];
+}
+
+const LightController* Network::controller(int intersection) const {
+	return controllers[intersection].get();
+}
+
+LightController::State& Network::lights(int intersection) {
+	return lights_[intersection];
+}
+
+const LightController::State& Network::lights(int intersection) const {
+	return lights_[intersection];
+}
+
+bool Network::routed() const {
+	for (auto& s : sources) {
+		if (s.hasDemand()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int Network::exitNumber(int id) const {
+	if (roadways[id]->kind() != Roadway::EXIT) {
+		return -1;
+	}
+	return static_cast<const ExitRoadway*>(roadways[id]) - exits.data();
+}
+
+bool Network::adaptive() const {
+	for (auto& c : controllers) {
+		if (c != nullptr) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const std::vector<int>& Network::controlledBy(int semaphore) const {
+	return controlled[semaphore];
+}
+
+int Network::queue(int semaphore) const {
+	int vehicles = 0;
+	for (int id : controlled[semaphore]) {
+		vehicles += roadways[id]->stopped();
+	}
+	return vehicles;
+}
+
+void Network::seed(const Random& random) {
+	Random stream = random;
+	for (auto r : roadways) {
+		r->setRandom(stream);
+		stream.jump();
+	}
+}
+
+int Network::roadwayCount() const {
+	return roadways.size();
+}
+
+int Network::semaphoreCount() const {
+	return semaphores.size();
+}
+
+int Network::intersectionCount() const {
+	return intersections.size();
+}
+
+int Network::totalIn() const {
+	int total = 0;
+	for (auto r : roadways) {
+		total += r->entered();
+	}
+	return total;
+}
+
+int Network::totalOut() const {
+	int total = 0;
+	for (auto r : roadways) {
+		total += r->left();
+	}
+	return total;
+}
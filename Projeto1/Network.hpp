@@ -0,0 +1,202 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef NETWORK_HPP
+#define NETWORK_HPP
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LightController.hpp"
+#include "PhasePlan.hpp"
+#include "Random.hpp"
+#include "Roadway.hpp"
+#include "Semaphore.hpp"
+
+/**
+ * @brief Owns every Roadway and Semaphore of a simulation
+ *
+ * Roadways and semaphores live in contiguous arrays (one per kind);
+ * events refer to them by id and the network maps ids back to objects.
+ * Each simulation has its own network, so counters are per-simulation.
+ *
+ * A network is described by a text file, one item per line ('#' starts
+ * a comment):
+ *
+ *   intersection <name> <green> <approach>...
+ *   phases  <intersection> <seconds>:<approach>[+<approach>...]...
+ *   control <intersection> fixed | max-pressure
+ *           | actuated [<threshold> <extension>]
+ *   exit    <name> <semaphore> <size> <velocity>
+ *   central <name> <semaphore> <size> <velocity>
+ *           <right> <straight> <left> <probLeft> <probRight>
+ *   source  <name> <semaphore> <size> <velocity> <fixedFreq> <variableFreq>
+ *           <right> <straight> <left> <probLeft> <probRight>
+ *   demand  <source> <exit> <weight>
+ *
+ * An intersection creates one semaphore per approach, named
+ * <name>.<approach>. Its lights follow a phase plan (see PhasePlan):
+ * the phases line gives each phase's seconds and the approaches that
+ * have the green in it ('-': none). Without one, the green goes back
+ * and forth between the first two approaches every <green> seconds (0:
+ * the frequency given on the command line). The control line picks
+ * how the plan runs (see LightController): fixed time, as it is, or
+ * adapted to the queues; '*' instead of a name sets it for the
+ * intersections without their own line, and the last such line wins.
+ * Roadways may refer to roadways declared further down the file. Sizes
+ * (m) and velocities (km/h) are positive, and a source creates a vehicle
+ * every fixedFreq +- variableFreq seconds, 0 <= variableFreq <= fixedFreq.
+ *
+ * Demand lines give the vehicles of a source a destination, drawn by
+ * weight, and the vehicles follow the fastest route there (see
+ * planRoutes); '*' stands for every source or every exit it can reach.
+ * Vehicles of a source without demand turn at random, with probLeft and
+ * probRight.
+ */
+class Network {
+public:
+	struct Intersection {
+		std::string name;
+		int firstSemaphore, semaphoreCount;
+		int green;  // Seconds between light changes (0: default)
+		std::vector<PhasePlan::Phase> phases;  // Empty: alternate on green
+		LightController::Settings control;
+	};
+
+	struct Demand {
+		int source, exit;  // Roadway ids
+		double weight;
+		bool required;  // Named: the exit must be reachable
+	};
+
+	static const char* const TWO_INTERSECTIONS;  // Built-in description
+	static const std::uint8_t UNREACHABLE = 0xff;  // In the route tables
+
+private:
+	std::vector<Semaphore> semaphores;
+	std::vector<Source> sources;
+	std::vector<CentralRoadway> centrals;
+	std::vector<ExitRoadway> exits;
+	std::vector<Roadway*> roadways;  // By id
+	std::vector<std::string> names;  // Roadway names, by id
+	std::vector<std::string> semaphoreNames;
+	std::vector<Intersection> intersections;
+	std::vector<PhasePlan> plans;  // By intersection, once planned
+	// By intersection, once planned; nullptr: fixed time
+	std::vector<std::unique_ptr<LightController>> controllers;
+	std::vector<LightController::State> lights_;  // Of the controllers
+	std::vector<std::vector<int>> controlled;  // By semaphore: roadway ids
+	std::vector<Demand> demands;
+	// By roadway, then by exit number: exit slot (right, straight, left)
+	// to the destination; one row of bytes per roadway
+	std::vector<std::uint8_t> routes;
+	std::unordered_map<std::string, int> roadwayIds, semaphoreIds;
+	std::unordered_map<std::string, int> intersectionIds;
+
+	void add(Roadway* r, const std::string& name);
+	template<typename T>
+	void checkCapacity(const std::vector<T>& v) const;
+	static void checkRoadway(int size, int velocity);
+
+public:
+	Network() = default;
+	Network(const Network&) = delete;
+	Network& operator=(const Network&) = delete;
+
+	/**
+	 * @brief Reserves the arrays; must be called before adding items
+	 *
+	 * Roadways keep pointers to each other and to their semaphores, so
+	 * the arrays can't grow once items have been added.
+	 */
+	void reserve(int semaphores, int sources, int centrals, int exits);
+
+	/**
+	 * @brief Reads a network description (see above)
+	 *
+	 * @throws std::runtime_error with the line number on invalid input
+	 */
+	void load(std::istream& in);
+
+	int addIntersection(const std::string& name, int green,
+		const std::vector<std::string>& approaches);
+	void setPhases(int intersection,
+		const std::vector<PhasePlan::Phase>& phases);
+	void setControl(int intersection,
+		const LightController::Settings& control);
+	void addDemand(const Demand& demand);
+
+	/**
+	 * @brief Gives every semaphore the phase plan of its intersection,
+	 * and adaptive intersections their controller
+	 *
+	 * Until then the lights are always green. Controllers start on the
+	 * first phase at time 0.
+	 *
+	 * @param defaultGreen Green of intersections declared with 0
+	 * @throws std::runtime_error with the intersection name on an
+	 *         invalid plan
+	 */
+	void planLights(int defaultGreen);
+
+	/**
+	 * @brief Builds the route tables and gives the sources their demand
+	 *
+	 * For each exit, a Dijkstra over the roadways (backwards from the
+	 * exit, each roadway weighing its timeToTravel()) gives every
+	 * roadway the exit slot on its fastest route there. Vehicles then
+	 * pick their exit with one lookup in their roadway's row. Nothing is
+	 * built without demand.
+	 *
+	 * @throws std::runtime_error if a named exit can't be reached from
+	 *         its source, or there are too many exits for the tables
+	 */
+	void planRoutes();
+	ExitRoadway& addExit(const std::string& name, Semaphore& semaphore,
+		int size, int velocity);
+	CentralRoadway& addCentral(const std::string& name, Semaphore& semaphore,
+		int size, int velocity, double probLeft, double probRight);
+	Source& addSource(const std::string& name, Semaphore& semaphore,
+		int size, int velocity, int fixedFrequency, int variableFrequency,
+		double probLeft, double probRight);
+
+	Roadway& roadway(int id) const;
+	Roadway& roadway(const std::string& name) const;
+	const std::string& name(int id) const;
+	Semaphore& semaphore(int id);
+	Semaphore& semaphore(const std::string& name);
+	const std::string& semaphoreName(int id) const;  // <intersection>.<approach>
+	const Intersection& intersection(int i) const;
+	const PhasePlan& plan(int intersection) const;
+	const LightController* controller(int intersection) const;  // Or null
+	LightController::State& lights(int intersection);  // Adaptive only
+	const LightController::State& lights(int intersection) const;
+	bool adaptive() const;  // Some intersection has a controller
+	bool routed() const;  // Some source has demand, once planned
+	int exitNumber(int id) const;  // Of an exit roadway; -1 if not one
+
+	// Roadways (no exits) that stop at the semaphore, and their vehicles
+	// stopped there
+	const std::vector<int>& controlledBy(int semaphore) const;
+	int queue(int semaphore) const;
+	int roadwayCount() const;
+	int semaphoreCount() const;
+	int intersectionCount() const;
+
+	/**
+	 * @brief Gives every roadway its own random stream
+	 *
+	 * Roadway i gets the engine jumped i times, so the numbers a roadway
+	 * draws don't depend on the order the roadways run in.
+	 */
+	void seed(const Random& random);
+
+	int totalIn() const;  // Vehicles that entered any roadway
+	int totalOut() const;  // Vehicles that left any roadway
+};
+
+#endif  // NETWORK_HPP
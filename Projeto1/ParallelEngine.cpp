@@ -0,0 +1,121 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "ParallelEngine.hpp"
+#include <algorithm>
+#include <climits>
+#include <thread>
+#include "Barrier.hpp"
+#include "binary_heap.h"
+#include "calendar_queue.h"
+
+ParallelEngine::ParallelEngine(Network& network, int partitions) :
+	network(network),
+	partitioning(network, partitions) {}
+
+template<typename Queue>
+void ParallelEngine::run(const std::vector<EventRecord>& initialEvents,
+		int totalTime, TraceFile* trace) {
+	int n = partitioning.count();
+	int lookahead = partitioning.lookahead();
+	std::vector<Queue> queues(n);
+	std::vector<std::vector<EventRecord>> channels(n * n);  // [from*n + to]
+	std::vector<int> nextTime(n, INT_MAX);  // Earliest event of each one
+	std::vector<std::size_t> peaks(n, 0);
+	std::vector<std::uint64_t> processed(n, 0);
+	Barrier barrier(n);
+
+	int start = INT_MAX;
+	for (auto& e : initialEvents) {
+		queues[partitioning.owner(e)].push(e.time, tieBreak(e), e);
+		start = std::min(start, e.time);
+	}
+
+	auto worker = [&](int p) {
+		Queue& events = queues[p];
+		EventSink newEvents;
+		TraceBuffer traced(trace);
+		peaks[p] = events.size();
+
+		for (int windowStart = start; windowStart <= totalTime; ) {
+			// Nothing sent in this window can fall inside it
+			long long end = std::min<long long>(
+				static_cast<long long>(windowStart) + lookahead,
+				static_cast<long long>(totalTime) + 1);
+
+			while (!events.empty() && events.top_key() < end) {
+				auto currentEvent = events.pop();
+				auto outcome = dispatch(currentEvent, network, newEvents);
+				traced.add(currentEvent, outcome);
+				processed[p]++;
+
+				for (auto i = 0; i < newEvents.size(); ++i) {
+					auto& e = newEvents[i];
+					int to = partitioning.owner(e);
+					if (to == p) {
+						events.push(e.time, tieBreak(e), e);
+					} else {
+						channels[p * n + to].push_back(e);
+					}
+				}
+				newEvents.clear();
+				peaks[p] = std::max(peaks[p], events.size());
+			}
+			barrier.wait();
+
+			for (int from = 0; from < n; ++from) {
+				auto& channel = channels[from * n + p];
+				for (auto& e : channel) {
+					events.push(e.time, tieBreak(e), e);
+				}
+				channel.clear();
+			}
+			peaks[p] = std::max(peaks[p], events.size());
+			nextTime[p] = events.empty() ? INT_MAX : events.top_key();
+			barrier.wait();
+
+			windowStart = *std::min_element(nextTime.begin(), nextTime.end());
+		}
+		traced.flush();
+	};
+
+	std::vector<std::thread> threads;
+	for (int p = 1; p < n; ++p) {
+		threads.emplace_back(worker, p);
+	}
+	worker(0);
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	peakEvents_ = 0;
+	eventsProcessed_ = 0;
+	for (int p = 0; p < n; ++p) {
+		peakEvents_ += peaks[p];
+		eventsProcessed_ += processed[p];
+	}
+}
+
+template void ParallelEngine::run<BinaryHeap<EventRecord>>(
+	const std::vector<EventRecord>& initialEvents, int totalTime,
+	TraceFile* trace);
+template void ParallelEngine::run<CalendarQueue<EventRecord>>(
+	const std::vector<EventRecord>& initialEvents, int totalTime,
+	TraceFile* trace);
+
+int ParallelEngine::partitions() const {
+	return partitioning.count();
+}
+
+int ParallelEngine::lookahead() const {
+	return partitioning.lookahead();
+}
+
+std::size_t ParallelEngine::peakEvents() const {
+	return peakEvents_;
+}
+
+std::uint64_t ParallelEngine::eventsProcessed() const {
+	return eventsProcessed_;
+}
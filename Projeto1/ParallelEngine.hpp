@@ -0,0 +1,57 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef PARALLEL_ENGINE_HPP
+#define PARALLEL_ENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Event.hpp"
+#include "Network.hpp"
+#include "Partitioning.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Runs one simulation on several threads (conservative PDES)
+ *
+ * Each partition (see Partitioning) has its own thread and queue of
+ * pending events, and events for another partition go through a
+ * channel. Partitions run all the events of a window as long as the
+ * lookahead on their own, so nothing they send can fall inside it; then
+ * they swap channels and agree on where the next window starts. Events
+ * at the same time are handled in tieBreak order, so the results are the
+ * same as the sequential run's.
+ */
+class ParallelEngine {
+private:
+	Network& network;
+	Partitioning partitioning;
+	std::size_t peakEvents_ = 0;
+	std::uint64_t eventsProcessed_ = 0;
+
+public:
+	/**
+	 * @throws std::runtime_error if a roadway is fed from two partitions
+	 */
+	ParallelEngine(Network& network, int partitions);
+
+	/**
+	 * @brief Runs the events up to (and including) totalTime
+	 *
+	 * @tparam Queue Pending-events queue: BinaryHeap or CalendarQueue
+	 * @param trace Where each partition writes the events it runs, if any
+	 */
+	template<typename Queue>
+	void run(const std::vector<EventRecord>& initialEvents, int totalTime,
+		TraceFile* trace = nullptr);
+
+	int partitions() const;
+	int lookahead() const;  // Window length (s); INT_MAX if none crosses
+
+	std::size_t peakEvents() const;  // Sum of the partitions' peaks
+	std::uint64_t eventsProcessed() const;
+};
+
+#endif  // PARALLEL_ENGINE_HPP
@@ -0,0 +1,114 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Partitioning.hpp"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+Partitioning::Partitioning(Network& network, int partitions) :
+	count_(std::max(1, std::min(partitions, network.intersectionCount()))),
+	lookahead_(INT_MAX),
+	entryOwner(network.roadwayCount(), -1),
+	exitOwner(network.roadwayCount(), -1),
+	semaphoreOwner(network.semaphoreCount(), 0),
+	intersectionOwner(network.intersectionCount()),
+	entrySides_(count_),
+	exitSides_(count_),
+	semaphores_(count_),
+	intersections_(count_) {
+	// Contiguous blocks of intersections
+	int intersections = network.intersectionCount();
+	for (int i = 0; i < intersections; ++i) {
+		auto& intersection = network.intersection(i);
+		intersectionOwner[i] = i * count_ / intersections;
+		intersections_[intersectionOwner[i]].push_back(i);
+		for (int k = 0; k < intersection.semaphoreCount; ++k) {
+			semaphoreOwner[intersection.firstSemaphore + k] =
+				intersectionOwner[i];
+		}
+	}
+	for (int s = 0; s < network.semaphoreCount(); ++s) {
+		semaphores_[semaphoreOwner[s]].push_back(s);
+	}
+
+	// The exit side runs where its semaphore is; exits have none that
+	// works, they run with the roadways that feed them
+	std::vector<int> feeder(network.roadwayCount(), -1);
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		Roadway& r = network.roadway(id);
+		if (r.kind() != Roadway::EXIT) {
+			exitOwner[id] = semaphoreOwner[r.getSemaphore().id()];
+		}
+	}
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		Roadway* exits[3];
+		network.roadway(id).exitsOf(exits);
+		for (auto e : exits) {
+			if (e == nullptr) {
+				continue;
+			}
+			int& f = feeder[e->id()];
+			if (f >= 0 && f != exitOwner[id]) {
+				throw std::runtime_error("Pista " + network.name(e->id()) +
+					" alimentada por duas partições");
+			}
+			f = exitOwner[id];
+		}
+	}
+
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		Roadway& r = network.roadway(id);
+		if (r.kind() == Roadway::EXIT) {
+			exitOwner[id] = feeder[id] >= 0 ? feeder[id] : 0;
+		}
+		entryOwner[id] = feeder[id] >= 0 ? feeder[id] : exitOwner[id];
+		entrySides_[entryOwner[id]].push_back(id);
+		exitSides_[exitOwner[id]].push_back(id);
+
+		// Only central roadways have their sides apart
+		if (entryOwner[id] != exitOwner[id]) {
+			if (r.kind() != Roadway::CENTRAL) {
+				throw std::runtime_error("Pista " + network.name(id) +
+					" alimentada por outra partição");
+			}
+			lookahead_ = std::min(lookahead_, r.timeToTravel());
+		}
+	}
+}
+
+int Partitioning::count() const {
+	return count_;
+}
+
+int Partitioning::lookahead() const {
+	return lookahead_;
+}
+
+int Partitioning::owner(const EventRecord& e) const {
+	switch (e.kind) {
+	case EventKind::SWITCH_PHASE:
+		return intersectionOwner[e.target];
+	case EventKind::FREE_SPACE:
+		return entryOwner[e.target];
+	default:
+		return exitOwner[e.target];
+	}
+}
+
+const std::vector<int>& Partitioning::entrySides(int p) const {
+	return entrySides_[p];
+}
+
+const std::vector<int>& Partitioning::exitSides(int p) const {
+	return exitSides_[p];
+}
+
+const std::vector<int>& Partitioning::semaphores(int p) const {
+	return semaphores_[p];
+}
+
+const std::vector<int>& Partitioning::intersections(int p) const {
+	return intersections_[p];
+}
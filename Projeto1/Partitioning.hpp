@@ -0,0 +1,53 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef PARTITIONING_HPP
+#define PARTITIONING_HPP
+
+#include <vector>
+#include "Event.hpp"
+#include "Network.hpp"
+
+/**
+ * @brief Splits a Network in partitions of contiguous intersections
+ *
+ * A partition owns the semaphores of its intersections and the exit side
+ * of the roadways those semaphores control; the entry side of a roadway
+ * belongs to the partition of the roadways that feed it (see Roadway).
+ * The events of a partition only touch what it owns, so partitions can
+ * run apart and only swap the events they schedule for each other.
+ *
+ * Only ARRIVE_VEHICLE and FREE_SPACE events on central roadways cross
+ * partitions, and they run timeToTravel() after they are scheduled. The
+ * smallest such time is the lookahead.
+ */
+class Partitioning {
+private:
+	int count_;
+	int lookahead_;
+	std::vector<int> entryOwner, exitOwner;  // By roadway id
+	std::vector<int> semaphoreOwner;  // By semaphore id
+	std::vector<int> intersectionOwner;  // By intersection id
+	std::vector<std::vector<int>> entrySides_, exitSides_, semaphores_;
+	std::vector<std::vector<int>> intersections_;
+
+public:
+	/**
+	 * @throws std::runtime_error if a roadway is fed from two partitions
+	 */
+	Partitioning(Network& network, int partitions);
+
+	int count() const;  // At most one per intersection
+	int lookahead() const;  // Seconds; INT_MAX if no roadway crosses
+	int owner(const EventRecord& e) const;  // Partition that runs e
+
+	// What partition p owns: roadway ids (by side), semaphore ids and
+	// intersection ids (whose controllers it runs)
+	const std::vector<int>& entrySides(int p) const;
+	const std::vector<int>& exitSides(int p) const;
+	const std::vector<int>& semaphores(int p) const;
+	const std::vector<int>& intersections(int p) const;
+};
+
+#endif  // PARTITIONING_HPP
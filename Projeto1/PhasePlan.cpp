@@ -0,0 +1,94 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "PhasePlan.hpp"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+PhasePlan::PhasePlan(const std::vector<Phase>& phases) : phases_(phases) {
+	if (phases.empty()) {
+		throw std::runtime_error("plano de fases vazio");
+	}
+	long long end = 0;
+	for (auto& phase : phases) {
+		if (phase.duration < 1) {
+			throw std::runtime_error("fase com duração menor que 1 s");
+		}
+		end += phase.duration;
+		if (end > INT_MAX / 2) {
+			throw std::runtime_error("ciclo de fases longo demais");
+		}
+		ends_.push_back(end);
+	}
+	cycle_ = end;
+}
+
+PhasePlan PhasePlan::alternating(int approaches, int green) {
+	if (approaches < 2) {
+		return PhasePlan({{green, 1}});
+	}
+	return PhasePlan({{green, 1}, {green, 2}});
+}
+
+int PhasePlan::phaseAt(int time, long long& cycleStart) const {
+	int offset = time % cycle_;
+	if (offset < 0) {
+		offset += cycle_;
+	}
+	cycleStart = static_cast<long long>(time) - offset;
+	return std::upper_bound(ends_.begin(), ends_.end(), offset) -
+		ends_.begin();
+}
+
+bool PhasePlan::open(int approach, int time) const {
+	long long cycleStart;
+	return phases_[phaseAt(time, cycleStart)].opens(approach);
+}
+
+long long PhasePlan::phaseStart(long long cycleStart, int m) const {
+	int n = phases_.size();
+	if (m >= n) {
+		cycleStart += cycle_;
+		m -= n;
+	}
+	return cycleStart + (m > 0 ? ends_[m - 1] : 0);
+}
+
+int PhasePlan::nextGreen(int approach, int time) const {
+	long long cycleStart;
+	int k = phaseAt(time, cycleStart);
+	if (phases_[k].opens(approach)) {
+		return time;
+	}
+	// The later phases, up to a whole cycle ahead
+	int n = phases_.size();
+	for (int m = k + 1; m < k + n; ++m) {
+		if (phases_[m % n].opens(approach)) {
+			return std::min<long long>(phaseStart(cycleStart, m), INT_MAX);
+		}
+	}
+	return INT_MAX;
+}
+
+int PhasePlan::nextChange(int approach, int time) const {
+	long long cycleStart;
+	int k = phaseAt(time, cycleStart);
+	bool now = phases_[k].opens(approach);
+	int n = phases_.size();
+	for (int m = k + 1; m < k + n; ++m) {
+		if (phases_[m % n].opens(approach) != now) {
+			return std::min<long long>(phaseStart(cycleStart, m), INT_MAX);
+		}
+	}
+	return INT_MAX;
+}
+
+int PhasePlan::cycle() const {
+	return cycle_;
+}
+
+const std::vector<PhasePlan::Phase>& PhasePlan::phases() const {
+	return phases_;
+}
@@ -0,0 +1,62 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef PHASE_PLAN_HPP
+#define PHASE_PLAN_HPP
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Light plan of one intersection: phases that repeat in a cycle
+ *
+ * Each phase lasts some seconds and gives the green to a set of the
+ * intersection's approaches; the first phase starts at time 0. The
+ * state of a light at any time comes from the time alone: the offset in
+ * the cycle and a binary search over the few phase ends, so no event
+ * has to change the lights.
+ */
+class PhasePlan {
+public:
+	struct Phase {
+		int duration;  // Seconds, at least 1
+		std::uint32_t green;  // Bit k: approach k of the intersection
+
+		bool opens(int approach) const {
+			return approach < MAX_APPROACHES && (green >> approach & 1);
+		}
+	};
+
+	static const int MAX_APPROACHES = 32;  // Bits of Phase::green
+
+	/**
+	 * @throws std::runtime_error if there are no phases or a phase lasts
+	 *         less than 1 s
+	 */
+	explicit PhasePlan(const std::vector<Phase>& phases);
+
+	/**
+	 * @brief The plan of an intersection without one: the green goes
+	 * back and forth between the first two approaches every green
+	 * seconds (a single approach is always green)
+	 */
+	static PhasePlan alternating(int approaches, int green);
+
+	bool open(int approach, int time) const;
+	int nextGreen(int approach, int time) const;  // >= time; INT_MAX: never
+	int nextChange(int approach, int time) const;  // > time; INT_MAX: never
+	int cycle() const;
+	const std::vector<Phase>& phases() const;
+
+private:
+	std::vector<Phase> phases_;
+	std::vector<int> ends_;  // Of each phase, from the start of the cycle
+	int cycle_ = 0;
+
+	int phaseAt(int time, long long& cycleStart) const;
+	// Start of phase m (m may go past the last) of the cycle at cycleStart
+	long long phaseStart(long long cycleStart, int m) const;
+};
+
+#endif  // PHASE_PLAN_HPP
@@ -0,0 +1,78 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Random.hpp"
+
+static inline std::uint64_t rotl(std::uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+Random::Random(std::uint64_t seed) {
+	this->seed(seed);
+}
+
+void Random::seed(std::uint64_t seed) {
+	for (int i = 0; i < 4; ++i) {
+		std::uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		s[i] = z ^ (z >> 31);
+	}
+}
+
+std::uint64_t Random::next() {
+	const std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+	const std::uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
+
+double Random::uniform() {
+	// 53 high bits as the mantissa of a double in [0, 1)
+	return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void Random::fill(double* out, int n) {
+	for (int i = 0; i < n; ++i) {
+		out[i] = uniform();
+	}
+}
+
+void Random::jump() {
+	static const std::uint64_t JUMP[] = {
+		0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+		0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+	jump(JUMP);
+}
+
+void Random::longJump() {
+	static const std::uint64_t LONG_JUMP[] = {
+		0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+		0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+	jump(LONG_JUMP);
+}
+
+void Random::jump(const std::uint64_t (&polynomial)[4]) {
+	std::uint64_t t[4] = {0, 0, 0, 0};
+	for (auto j : polynomial) {
+		for (int b = 0; b < 64; ++b) {
+			if (j & (std::uint64_t(1) << b)) {
+				for (int i = 0; i < 4; ++i) {
+					t[i] ^= s[i];
+				}
+			}
+			next();
+		}
+	}
+	for (int i = 0; i < 4; ++i) {
+		s[i] = t[i];
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+/**
+ * @brief Random number engine of one simulation (xoshiro256**)
+ *
+ * Replaces the global rand(): each simulation owns its engine, so runs
+ * are reproducible from their seed and simulations in different threads
+ * don't share state. jump() and longJump() give independent streams.
+ */
+class Random {
+private:
+	std::uint64_t s[4];
+
+public:
+	explicit Random(std::uint64_t seed = 0);
+
+	void seed(std::uint64_t seed);  // Expands seed with splitmix64
+	std::uint64_t next();  // Uniform 64-bit integer
+	double uniform();  // Uniform double in [0, 1)
+
+	/**
+	 * @brief Fills out with n uniform doubles in [0, 1)
+	 */
+	void fill(double* out, int n);
+
+	/**
+	 * @brief Advances the engine by 2^128 numbers
+	 *
+	 * Streams obtained by jumping the same engine 0, 1, 2... times
+	 * never overlap in practice.
+	 */
+	void jump();
+
+	/**
+	 * @brief Advances the engine by 2^192 numbers
+	 *
+	 * Gives streams of streams: long jumps separate replications, jumps
+	 * separate the roadways of one replication.
+	 */
+	void longJump();
+
+private:
+	void jump(const std::uint64_t (&polynomial)[4]);
+};
+
+#endif  // RANDOM_HPP
@@ -0,0 +1,108 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Replications.hpp"
+#include <atomic>
+#include <thread>
+
+Replications::Replications(int count, int threads, std::uint64_t masterSeed,
+		const std::string& description) :
+	count(count),
+	threads(threads > 0 ? threads : std::thread::hardware_concurrency()),
+	masterSeed(masterSeed),
+	description(description) {
+	if (this->threads < 1) {
+		this->threads = 1;
+	}
+}
+
+void Replications::run(int totalTime, int semaphFrequency,
+		Simulation::Scheduler scheduler) {
+	results.assign(count, Result());
+	std::atomic<int> next(0);
+
+	// Independent random streams, one per replication
+	std::vector<Random> streams;
+	Random stream(masterSeed);
+	for (int i = 0; i < count; ++i) {
+		streams.push_back(stream);
+		stream.longJump();
+	}
+
+	// Each worker takes the next replication until none is left
+	auto worker = [&]() {
+		for (int i = next++; i < count; i = next++) {
+			Simulation simulation(description, semaphFrequency, streams[i]);
+			simulation.run(totalTime, scheduler);
+
+			const Network& network = simulation.network();
+			Result& r = results[i];
+			r.totalIn = network.totalIn();
+			r.totalOut = network.totalOut();
+			for (int id = 0; id < network.roadwayCount(); ++id) {
+				r.entered.push_back(network.roadway(id).entered());
+				r.left.push_back(network.roadway(id).left());
+				r.areIn.push_back(network.roadway(id).areIn());
+			}
+			if (i == 0) {
+				for (int id = 0; id < network.roadwayCount(); ++id) {
+					names.push_back(network.name(id));
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; ++t) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto& t : pool) {
+		t.join();
+	}
+}
+
+void Replications::print(std::ostream& out) const {
+	auto column = [&](int Result::*field) {
+		std::vector<double> sample;
+		for (auto& r : results) {
+			sample.push_back(r.*field);
+		}
+		return Estimate::of(sample);
+	};
+	auto roadwayColumn = [&](std::vector<int> Result::*field, int id) {
+		std::vector<double> sample;
+		for (auto& r : results) {
+			sample.push_back((r.*field)[id]);
+		}
+		return Estimate::of(sample);
+	};
+	auto show = [&](const Estimate& e) {
+		out << e.mean << " +- " << e.halfWidth;
+	};
+
+	Estimate in = column(&Result::totalIn);
+	Estimate left = column(&Result::totalOut);
+
+	out << "--------------------\n"
+	<< "   RELATÓRIO DAS REPLICAÇÕES\n"
+	<< "Replicações: " << count << " (semente " << masterSeed << ")\n"
+	<< "Intervalos de confiança de 95%\n"
+	<< "Entraram: ";
+	show(in);
+	out << "\nSaíram: ";
+	show(left);
+	out << "\n\nPistas\n";
+
+	for (auto id = 0u; id < names.size(); ++id) {
+		out << names[id] << " { Entraram: ";
+		show(roadwayColumn(&Result::entered, id));
+		out << " Sairam: ";
+		show(roadwayColumn(&Result::left, id));
+		out << " Estão dentro: ";
+		show(roadwayColumn(&Result::areIn, id));
+		out << " }\n";
+	}
+	out << "--------------------\n" << std::endl;
+}
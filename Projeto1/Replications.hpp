@@ -0,0 +1,51 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef REPLICATIONS_HPP
+#define REPLICATIONS_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Simulation.hpp"
+#include "Statistics.hpp"
+
+/**
+ * @brief Runs independent replications of the simulation on all cores
+ *
+ * Replication i uses the engine seeded with masterSeed and long-jumped i
+ * times, so the results only depend on the master seed, not on the
+ * threads.
+ */
+class Replications {
+private:
+	int count, threads;
+	std::uint64_t masterSeed;
+	std::string description;  // Network description
+
+	struct Result {  // Counters of one replication
+		int totalIn = 0, totalOut = 0;
+		std::vector<int> entered, left, areIn;  // By roadway id
+	};
+	std::vector<Result> results;
+	std::vector<std::string> names;  // Roadway names, by id
+
+public:
+	/**
+	 * @param count Number of replications
+	 * @param threads Worker threads (0: one per core)
+	 * @param masterSeed Seed the replications' seeds are derived from
+	 * @param description Network description (see Network)
+	 */
+	Replications(int count, int threads, std::uint64_t masterSeed,
+		const std::string& description);
+
+	void run(int totalTime, int semaphFrequency,
+		Simulation::Scheduler scheduler = Simulation::HEAP);
+
+	void print(std::ostream& out) const;  // Means and confidence intervals
+};
+
+#endif  // REPLICATIONS_HPP
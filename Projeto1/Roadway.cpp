@@ -3,35 +3,170 @@
 // Leticia do Nascimento
 
 #include "Roadway.hpp"
-#include <cstdlib>
+#include <algorithm>
 
-int Roadway::totalIn_ = 0;
-int Roadway::totalOut_ = 0;
-
-Roadway::Roadway(Semaphore& semaphore, int size, int velocity,
+Roadway::Roadway(Kind kind, Semaphore& semaphore, int size, int velocity,
 		double probLeft, double probRight):
+	kind_(kind),
 	semaphore(semaphore),
+	queue(size / Vehicle::SIZE_ + 1),
+	length(size),
 	size(size),
 	velocity(velocity),
 	probLeft(probLeft),
 	probRight(probRight) {}
 
-void Roadway::add(Vehicle v) {
-	if (v.getSize() > size) {
-		throw std::runtime_error("Roadway currently full");
+Roadway::Kind Roadway::kind() const {
+	return kind_;
+}
+
+int Roadway::id() const {
+	return id_;
+}
+
+void Roadway::setId(int id) {
+	id_ = id;
+}
+
+void Roadway::setRandom(const Random& random) {
+	this->random = random;
+}
+
+Semaphore& Roadway::getSemaphore() const {
+	return semaphore;
+}
+
+void Roadway::setExits(Roadway* right, Roadway* straight, Roadway* left) {
+	rightExit = right;
+	straightExit = straight;
+	leftExit = left;
+}
+
+void Roadway::exitsOf(Roadway* exits[3]) const {
+	exits[0] = rightExit;
+	exits[1] = straightExit;
+	exits[2] = leftExit;
+}
+
+void Roadway::exitChances(double chances[3]) const {
+	chances[0] = 1 - probRight;
+	chances[1] = probRight - probLeft;
+	chances[2] = probLeft;
+}
+
+Roadway* Roadway::pickExit() {
+	double r = random.uniform();
+	if (r > probRight) {
+		return rightExit;
+	} else if (r < probLeft) {
+		return leftExit;
+	}
+	return straightExit;
+}
+
+Roadway* Roadway::pickExit(const Vehicle& vehicle) {
+	int destination = vehicle.getDestination();
+	if (destination < 0 || routes == nullptr) {
+		return pickExit();
+	}
+	switch (routes[destination]) {
+	case 0:
+		return rightExit;
+	case 1:
+		return straightExit;
+	default:
+		return leftExit;
+	}
+}
+
+void Roadway::setRoutes(const std::uint8_t* routes) {
+	this->routes = routes;
+}
+
+int Roadway::capacity() const {
+	return length;
+}
+
+int Roadway::space() const {
+	return size;
+}
+
+bool Roadway::tryEnter(int vehicleSize) {
+	if (vehicleSize > size) {
+		blocked_++;
+		return false;
 	}
 
-	size -= v.getSize();
+	size -= vehicleSize;
 	in++;
-	totalIn_++;
+	return true;
+}
+
+void Roadway::enter(int vehicleSize) {
+	if (!tryEnter(vehicleSize)) {
+		throw std::runtime_error("Roadway currently full");
+	}
+}
+
+void Roadway::arrive(Vehicle v, int time) {
+	v.setArrival(time);
 	queue.enqueue(v);
+	statistics_.change(time, +1);
 }
 
-Vehicle Roadway::pop() {
+Vehicle Roadway::depart(int time) {
 	auto v = queue.dequeue();
-	size += v.getSize();
 	out++;
-	totalOut_++;
+	statistics_.change(time, -1);
+	statistics_.waited(time - v.getArrival());
+	return v;
+}
+
+void Roadway::release(int vehicleSize) {
+	size += vehicleSize;
+}
+
+void Roadway::wait(int roadway, int vehicleSize) {
+	waiters.enqueue({roadway, vehicleSize});
+}
+
+int Roadway::wakeWaiter() {
+	if (waiters.empty() || waiters.front().size > size) {
+		return -1;
+	}
+	return waiters.dequeue().roadway;
+}
+
+void Roadway::stop() {
+	stopped_++;
+}
+
+int Roadway::stopped() const {
+	return stopped_;
+}
+
+bool Roadway::stuck() const {
+	return stopped_ > 0 && nextExit != nullptr &&
+		queue.front().getSize() > nextExit->size;
+}
+
+Roadway::Status Roadway::tryAdd(Vehicle v, int time) {
+	if (!tryEnter(v.getSize())) {
+		return FULL;
+	}
+	arrive(v, time);
+	return DONE;
+}
+
+void Roadway::add(Vehicle v, int time) {
+	if (tryAdd(v, time) != DONE) {
+		throw std::runtime_error("Roadway currently full");
+	}
+}
+
+Vehicle Roadway::pop(int time) {
+	auto v = depart(time);
+	release(v.getSize());
 	return v;
 }
 
@@ -39,12 +174,96 @@ bool Roadway::empty() {
 	return queue.empty();
 }
 
-Roadway& Roadway::moveVehicle() {
-	throw std::logic_error("Roadway::moveVehicle not implemented");
+Roadway::Status Roadway::tryMove(int time, Roadway*& next, Vehicle& vehicle) {
+	if (rightExit == nullptr)
+		throw std::logic_error("Roadway::tryMove on a roadway without exits");
+	if (stopped_ == 0)
+		throw std::logic_error("Roadway::tryMove with no vehicle stopped");
+
+	if (!semaphore.open(time))
+		return RED_LIGHT;
+
+	vehicle = queue.front();
+	if (nextExit == nullptr) {
+		nextExit = pickExit(vehicle);
+	}
+	next = nextExit;
+	if (!next->tryEnter(vehicle.getSize())) {
+		return FULL;
+	}
+
+	vehicle = kind_ == CENTRAL ? depart(time) : pop(time);
+	if (next->kind_ != CENTRAL) {
+		next->arrive(vehicle, time);
+	}
+	stopped_--;
+	nextExit = nullptr;
+	return DONE;
+}
+
+Roadway& Roadway::moveVehicle(int time, int& vehicleSize) {
+	Roadway* next;
+	Vehicle vehicle;
+	auto status = tryMove(time, next, vehicle);
+	vehicleSize = vehicle.getSize();
+	switch (status) {
+	case RED_LIGHT:
+		throw std::runtime_error("Red Semaphore");
+	case FULL:
+		throw std::runtime_error("Roadway currently full");
+	default:
+		return *next;
+	}
 }
 
 int Roadway::timeToTravel() const {
-	return size / velocity / 3.6;
+	// length in m, velocity in km/h
+	int time = length * 3.6 / velocity;
+	return time > 0 ? time : 1;
+}
+
+void Roadway::save(EntryState& state) const {
+	state.size = size;
+	state.in = in;
+	state.blocked = blocked_;
+	state.waiters.clear();
+	waiters.for_each([&](const Waiter& w) {
+		state.waiters.push_back(w);
+	});
+}
+
+void Roadway::restore(const EntryState& state) {
+	size = state.size;
+	in = state.in;
+	blocked_ = state.blocked;
+	waiters.clear();
+	for (auto& w : state.waiters) {
+		waiters.enqueue(w);
+	}
+}
+
+void Roadway::save(ExitState& state) const {
+	state.out = out;
+	state.stopped = stopped_;
+	state.nextExit = nextExit;
+	state.random = random;
+	state.queue.clear();
+	queue.for_each([&](const Vehicle& v) {
+		state.queue.push_back(v);
+	});
+	state.statistics = statistics_;
+}
+
+void Roadway::restore(const ExitState& state) {
+	out = state.out;
+	stopped_ = state.stopped;
+	nextExit = state.nextExit;
+	random = state.random;
+	queue.clear();
+	for (auto& v : state.queue) {
+		queue.enqueue(v);
+	}
+	statistics_ = state.statistics;
 }
 
 int Roadway::entered() const {
@@ -59,79 +278,93 @@ int Roadway::areIn() const {
 	return in-out;
 }
 
-int Roadway::totalIn() {
-	return totalIn_;
+int Roadway::blocked() const {
+	return blocked_;
+}
+
+const QueueStatistics& Roadway::statistics() const {
+	return statistics_;
 }
 
-int Roadway::totalOut() {
-	return totalOut_;
+void Roadway::restartStatistics(int time) {
+	statistics_.restart(time);
 }
 
 CentralRoadway::CentralRoadway(Semaphore& semaphore, int size, int velocity,
-		Roadway& rightExit, Roadway& straightExit, Roadway& leftExit,
 		double probLeft, double probRight):
-    Roadway(semaphore, size, velocity, probLeft, probRight),
-	rightExit(rightExit),
-	straightExit(straightExit),
-	leftExit(leftExit) {}
+	Roadway(CENTRAL, semaphore, size, velocity, probLeft, probRight) {}
 
+Source::Source(Semaphore& semaphore, int size, int velocity, int fixedFrequency,
+		int variableFrequency, double probLeft, double probRight):
+	Roadway(SOURCE, semaphore, size, velocity, probLeft, probRight),
+	fixedFrequency(fixedFrequency - variableFrequency),
+	variableFrequency(2*variableFrequency) {}
 
-Roadway& CentralRoadway::moveVehicle() {
-	if (!semaphore.getOpen())
-		throw std::runtime_error("Red Semaphore");
+bool Source::tryCreateVehicle(int time) {
+	auto v = Vehicle::withSize(nextVehicleSize());
+	if (!tryEnter(v.getSize())) {
+		return false;  // Same vehicle next time
+	}
+	if (!demand.empty()) {
+		// Drawn once it is in, so a retry doesn't draw again
+		double u = random.uniform() * demand.back();
+		auto i = std::upper_bound(demand.begin(), demand.end() - 1, u) -
+			demand.begin();
+		v.setDestination(destinations[i]);
+	}
+	arrive(v, time);
+	nextSize++;
+	return true;
+}
 
-	double r = rand()/RAND_MAX;
-	auto v = pop();
+int Source::nextVehicleSize() {
+	if (nextSize == SIZE_BATCH) {
+		random.fill(sizes, SIZE_BATCH);
+		nextSize = 0;
+	}
+	return Vehicle(sizes[nextSize]).getSize();
+}
 
-	if (r > probRight) {
-		rightExit.add(v);
-		return rightExit;
-	} else if (r < probLeft) {
-		leftExit.add(v);
-		return leftExit;
-	}  else {
-		straightExit.add(v);
-		return straightExit;
+int Source::takeVehicleSize() {
+	int size = nextVehicleSize();
+	nextSize++;
+	return size;
+}
+
+void Source::createVehicle(int time) {
+	if (!tryCreateVehicle(time)) {
+		throw std::runtime_error("Roadway currently full");
 	}
 }
 
-Source::Source(Semaphore& semaphore, int size, int velocity, int fixedFrequency,
-		int variableFrequency, Roadway& rightExit, Roadway& straightExit,
-		Roadway& leftExit, double probLeft, double probRight):
-	Roadway(semaphore, size, velocity, probLeft, probRight),
-	fixedFrequency(fixedFrequency - variableFrequency),
-	variableFrequency(2*variableFrequency),
-	rightExit(rightExit),
-	straightExit(straightExit),
-	leftExit(leftExit) {}
+void Source::save(ExitState& state) const {
+	Roadway::save(state);
+	state.batch.assign(sizes + nextSize, sizes + SIZE_BATCH);
+}
 
-void Source::createVehicle() {
-	Vehicle v;
-	add(v);
+void Source::restore(const ExitState& state) {
+	Roadway::restore(state);
+	nextSize = SIZE_BATCH - state.batch.size();
+	std::copy(state.batch.begin(), state.batch.end(), sizes + nextSize);
 }
 
-Roadway& Source::moveVehicle() {
-	if (!semaphore.getOpen())
-		throw std::runtime_error("Red Semaphore");
+int Source::nextEventsTime(int time) {
+	return time + fixedFrequency + variableFrequency * random.uniform();
+}
 
-	double r = (rand())/RAND_MAX;
-	auto v = pop();
+void Source::clearDemand() {
+	demand.clear();
+	destinations.clear();
+}
 
-	if (r > probRight) {
-		rightExit.add(v);
-		return rightExit;
-	} else if (r < probLeft) {
-		leftExit.add(v);
-		return leftExit;
-	}  else {
-		straightExit.add(v);
-		return straightExit;
-	}
+void Source::addDemand(int exit, double weight) {
+	demand.push_back(weight + (demand.empty() ? 0 : demand.back()));
+	destinations.push_back(exit);
 }
 
-int Source::nextEventsTime(int time) {
-	return time + fixedFrequency + variableFrequency * float(rand())/RAND_MAX;
+bool Source::hasDemand() const {
+	return !demand.empty();
 }
 
 ExitRoadway::ExitRoadway(Semaphore& semaphore, int size, int velocity):
-	Roadway(semaphore, size, velocity, 0, 0) {}
\ No newline at end of file
+	Roadway(EXIT, semaphore, size, velocity, 0, 0) {}
\ No newline at end of file
@@ -1,66 +1,188 @@
 #ifndef Roadway_HPP
 #define Roadway_HPP
 
-#include "linked_queue.h"
+#include <cstdint>
+#include <vector>
+#include "ring_queue.h"
+#include "Random.hpp"
+#include "Statistics.hpp"
 #include "Vehicle.hpp"
 #include "Semaphore.hpp"
 
 /**
  * @brief Class that represents a roadway
+ *
+ * Vehicles that get to the semaphore stop there (stop()) and leave in
+ * order. When the first one can't go, the roadway waits in a list: the
+ * semaphore's, if the light is red, or the entry side's of the exit the
+ * vehicle picked, if it is full. It is woken up (see ChangeRoadwayEv)
+ * as soon as the light turns green or the exit gives space back, so
+ * nothing polls and no vehicle is dropped.
+ *
+ * A roadway has two sides: the entry side holds the free space and the
+ * count of vehicles that entered, the exit side holds the queue at the
+ * semaphore and the count of vehicles that left. On sources and exits
+ * both sides change at once (add/pop). On a central roadway, vehicles
+ * enter immediately but join the queue only after timeToTravel()
+ * (arrive), and the space a vehicle leaves is given back to the entry
+ * side timeToTravel() later (release). So the two sides of a central
+ * roadway only talk through delayed events and can be run apart (see
+ * ParallelEngine).
+ *
+ * A vehicle with a destination takes the exit its route table gives
+ * (see Network::planRoutes); one without draws it with probLeft and
+ * probRight.
  */
 class Roadway {
+public:
+	enum Kind { SOURCE, CENTRAL, EXIT };
+	enum Status { DONE, FULL, RED_LIGHT };  // Outcome of tryAdd/tryMove
+
+	struct Waiter {  // Roadway waiting for space, and the space it needs
+		int roadway, size;
+	};
+
+	// Copies of each side, to go back to them later (see TimeWarpEngine)
+	struct EntryState {
+		int size, in, blocked;
+		std::vector<Waiter> waiters;  // First to last
+	};
+	struct ExitState {
+		int out, stopped;
+		Roadway* nextExit;
+		Random random;
+		std::vector<Vehicle> queue;  // First to last
+		std::vector<double> batch;  // Sources: sizes not used yet
+		QueueStatistics statistics;
+	};
+
 protected:
+	Kind kind_;
+	int id_ = -1;  // Index in the Network
+	Random random;  // Own stream, seeded by the Network
 	Semaphore& semaphore;
-	LinkedQueue<Vehicle> queue;
-	int size = 0, velocity = 0;
+	RingQueue<Vehicle> queue;  // Room for as many as fit, from the start
+	int length = 0, size = 0, velocity = 0;  // size: free space
 	int in = 0, out = 0;
+	int blocked_ = 0;  // Vehicles that found it full
+	RingQueue<Waiter> waiters;  // Entry side: roadways waiting for space
+	int stopped_ = 0;  // Exit side: vehicles at the semaphore
+	Roadway* nextExit = nullptr;  // Exit picked by the first of those
+	QueueStatistics statistics_;
 	double probLeft, probRight;
-	static int totalIn_, totalOut_;
+	Roadway *rightExit = nullptr, *straightExit = nullptr, *leftExit = nullptr;
+	const std::uint8_t* routes = nullptr;  // Exit (slot) by destination
 
 public:
-	Roadway(Semaphore& semaphore, int size, int velocity, double probLeft, double probRight);
-	void add(Vehicle vehicle);
-	Vehicle pop();
+	Roadway(Kind kind, Semaphore& semaphore, int size, int velocity,
+		double probLeft, double probRight);
+	virtual ~Roadway() {}
+	Kind kind() const;
+	int id() const;
+	void setId(int id);
+	void setRandom(const Random& random);
+	Semaphore& getSemaphore() const;
+	void setExits(Roadway* right, Roadway* straight, Roadway* left);
+	void exitsOf(Roadway* exits[3]) const;  // Right, straight, left
+	void exitChances(double chances[3]) const;  // Of pickExit, same order
+	Roadway* pickExit();  // Draws the exit of a vehicle
+	Roadway* pickExit(const Vehicle& vehicle);  // Its route's, or drawn
+	void setRoutes(const std::uint8_t* routes);  // Owned by the Network
+	int capacity() const;  // Free space (m) when empty
+	int space() const;  // Entry side: free space (m) now
+
+	// A full roadway or a red light is the normal case in a jam: the
+	// try* methods report it, the others throw std::runtime_error
+	bool tryEnter(int vehicleSize);  // Entry side: takes space
+	void enter(int vehicleSize);
+	void arrive(Vehicle vehicle, int time);  // Exit side: joins the queue
+	Vehicle depart(int time);  // Exit side: leaves the queue
+	void release(int vehicleSize);  // Entry side: gives space back
+	void wait(int roadway, int vehicleSize);  // Entry side: joins waiters
+	int wakeWaiter();  // Entry side: first waiter if it fits now, else -1
+	void stop();  // Exit side: one more vehicle at the semaphore
+	int stopped() const;
+	bool stuck() const;  // The first stopped one has no space on its exit
+	Status tryAdd(Vehicle vehicle, int time);  // tryEnter + arrive
+	void add(Vehicle vehicle, int time);
+	Vehicle pop(int time);  // depart + release
 	bool empty();
-	virtual Roadway& moveVehicle();
-	int timeToTravel() const;
+
+	/**
+	 * @brief Moves the first vehicle stopped at the semaphore to one of
+	 * the exits
+	 *
+	 * The vehicle picks its exit once and keeps it until it can go.
+	 * Leaves a central roadway with depart() and enters a central exit
+	 * with tryEnter(); the caller schedules the matching release() and
+	 * arrive(). Unless DONE, the vehicle stays where it is.
+	 *
+	 * @param time Current time
+	 * @param next Exit the vehicle picked (unless RED_LIGHT)
+	 * @param vehicle The vehicle (unless RED_LIGHT)
+	 * @return DONE, RED_LIGHT or FULL (next has no space for it)
+	 * @throws std::logic_error if no vehicle is stopped
+	 */
+	Status tryMove(int time, Roadway*& next, Vehicle& vehicle);
+	Roadway& moveVehicle(int time, int& vehicleSize);
+	int timeToTravel() const;  // Seconds to cover the roadway, at least 1
+
+	void save(EntryState& state) const;
+	void restore(const EntryState& state);
+	virtual void save(ExitState& state) const;
+	virtual void restore(const ExitState& state);
 	int entered() const;
 	int left() const;
 	int areIn() const;
-	static int totalIn();
-	static int totalOut();
+	int blocked() const;
+	const QueueStatistics& statistics() const;
+	void restartStatistics(int time);  // Drops the queue's warm-up
 };
 
 /**
  * @brief Source Roadway -- creates vehicles
  */
 class Source : public Roadway {
+public:
+	static const int SIZE_BATCH = 16;  // Vehicle sizes drawn at once
+
 private:
 	int fixedFrequency = 0, variableFrequency = 0;
-	Roadway &rightExit, &straightExit, &leftExit;
+	std::vector<double> demand;  // Cumulative weights of the destinations
+	std::vector<int> destinations;  // Exit numbers
+
+	double sizes[SIZE_BATCH];
+	int nextSize = SIZE_BATCH;
 
 public:
 	Source(Semaphore& semaphore, int size, int velocity, int fixedFrequency, 
-		int variableFrequency, Roadway& rightExit, Roadway& straightExit, Roadway& leftExit,
-		double probLeft, double probRight);
+		int variableFrequency, double probLeft, double probRight);
 
-	void createVehicle();
-	virtual Roadway& moveVehicle();
+	bool tryCreateVehicle(int time);  // False if the source is full
+	int nextVehicleSize();  // Of the vehicle tryCreateVehicle will add
+	int takeVehicleSize();  // Same, and moves on to the next vehicle
+	void createVehicle(int time);
 	int nextEventsTime(int time);
+
+	// Destinations its vehicles are drawn from, by weight; none: the
+	// vehicles have no destination
+	void clearDemand();
+	void addDemand(int exit, double weight);
+	bool hasDemand() const;
+
+	void save(ExitState& state) const;
+	void restore(const ExitState& state);
+	using Roadway::save;
+	using Roadway::restore;
 };
 
 /**
  * @brief Central Roadway
  */
 class CentralRoadway : public Roadway {
-private:
-	Roadway &rightExit, &straightExit, &leftExit;
-
 public:
 	CentralRoadway(Semaphore& semaphore, int size, int velocity,
-		Roadway& rightExit, Roadway& straightExit, Roadway& leftExit,
 		double probLeft, double probRight);
-	virtual Roadway& moveVehicle();
 };
 
 /**
@@ -1,24 +1,74 @@
 #include "Semaphore.hpp"
+#include <climits>
 
-Semaphore::Semaphore():
-	open{false},
-	nextSemaphore{nullptr}
-	{}
+Semaphore::Semaphore() {}
 
-Semaphore::Semaphore(bool open_):
-	open{open_},
-	nextSemaphore{nullptr}
-	{}
+void Semaphore::setPlan(const PhasePlan* plan_, int approach_,
+		const LightController::State* lights_) {
+	plan = plan_;
+	approach = approach_;
+	lights = lights_;
+}
+
+bool Semaphore::open(int time) const {
+	if (lights != nullptr) {
+		return plan->phases()[lights->phase].opens(approach);
+	}
+	return plan == nullptr || plan->open(approach, time);
+}
+
+int Semaphore::nextGreen(int time) const {
+	if (lights != nullptr) {
+		return open(time) ? time : lights->end;
+	}
+	return plan == nullptr ? time : plan->nextGreen(approach, time);
+}
+
+int Semaphore::nextChange(int time) const {
+	if (lights != nullptr) {
+		return lights->end;
+	}
+	return plan == nullptr ? INT_MAX : plan->nextChange(approach, time);
+}
 
-void Semaphore::nextState() {
-	open = !open;
-	nextSemaphore->open = !(nextSemaphore->open);
+void Semaphore::wait(int roadway) {
+	waiters.enqueue(roadway);
 }
 
-bool Semaphore::getOpen() const {
-	return open;
+int Semaphore::wakeWaiter(int time, int& when) {
+	if (waiters.empty()) {
+		return -1;
+	}
+	when = nextGreen(time);
+	if (when != time) {
+		if (when == INT_MAX || when == wakeup) {
+			return -1;
+		}
+		wakeup = when;
+	}
+	return waiters.dequeue();
 }
 
-void Semaphore::setNext(Semaphore* s_) {
-	nextSemaphore = s_;
-}
\ No newline at end of file
+void Semaphore::save(State& state) const {
+	state.wakeup = wakeup;
+	state.waiters.clear();
+	waiters.for_each([&](int roadway) {
+		state.waiters.push_back(roadway);
+	});
+}
+
+void Semaphore::restore(const State& state) {
+	wakeup = state.wakeup;
+	waiters.clear();
+	for (auto roadway : state.waiters) {
+		waiters.enqueue(roadway);
+	}
+}
+
+int Semaphore::id() const {
+	return id_;
+}
+
+void Semaphore::setId(int id) {
+	id_ = id;
+}
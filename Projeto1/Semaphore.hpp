@@ -1,17 +1,52 @@
 #ifndef SEMAPHORE_HPP
 #define SEMAPHORE_HPP
 
+#include <vector>
+#include "LightController.hpp"
+#include "PhasePlan.hpp"
+#include "ring_queue.h"
+
 class Semaphore {
+public:
+	// Copy of the waiters (see TimeWarpEngine)
+	struct State {
+		int wakeup;
+		std::vector<int> waiters;  // First to last
+	};
+
 private:
-	Semaphore* nextSemaphore;
-	bool open;
+	const PhasePlan* plan = nullptr;  // Of the intersection; none: green
+	const LightController::State* lights = nullptr;  // Adaptive only
+	int approach = 0;  // Index in the plan
+	int id_ = -1;  // Index in the Network
+	int wakeup = -1;  // Green a waiter was woken up for already
+	RingQueue<int> waiters;  // Roadways waiting for the green
 
 public:
 	Semaphore();
-	Semaphore(bool open_);
-	void nextState();
-	bool getOpen() const;
-	void setNext(Semaphore* s_);
+	// lights_: phase picked by the intersection's controller, if any
+	void setPlan(const PhasePlan* plan_, int approach_,
+		const LightController::State* lights_ = nullptr);
+	bool open(int time) const;
+
+	// Adaptive: the next decision stands for both (see LightController)
+	int nextGreen(int time) const;  // >= time; INT_MAX: never
+	int nextChange(int time) const;  // > time; INT_MAX: never
+	void wait(int roadway);
+
+	/**
+	 * @brief First waiter, to try again at time `when`
+	 *
+	 * When green, now. When red, at the next green (or decision), but
+	 * only one waiter per green: that one wakes the others up in turn.
+	 *
+	 * @return Roadway id, or -1 if none
+	 */
+	int wakeWaiter(int time, int& when);
+	void save(State& state) const;
+	void restore(const State& state);
+	int id() const;
+	void setId(int id);
 };
 
-#endif // SEMAPHORE_HPP
\ No newline at end of file
+#endif // SEMAPHORE_HPP
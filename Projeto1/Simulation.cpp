@@ -0,0 +1,276 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Simulation.hpp"
+#include <algorithm>
+#include <climits>
+#include <sstream>
+#include <stdexcept>
+#include "Checkpoint.hpp"
+#include "Metrics.hpp"
+#include "ParallelEngine.hpp"
+#include "TimeSteppedEngine.hpp"
+#include "TimeWarpEngine.hpp"
+#include "binary_heap.h"
+#include "calendar_queue.h"
+
+Simulation::Simulation(const std::string& description, int semaphFrequency,
+		const Random& random) :
+	description_(description),
+	networkKey_(networkKey(description, semaphFrequency)) {
+	std::istringstream in(description_);
+	network_.load(in);
+	network_.planLights(semaphFrequency);
+	network_.planRoutes();
+	network_.seed(random);
+
+	// Initial events
+	for (int i = 0; i < network_.intersectionCount(); ++i) {
+		if (network_.controller(i) != nullptr) {
+			initialEvents.push_back({network_.lights(i).end, i, 0,
+				EventKind::SWITCH_PHASE, 0, 0});
+		}
+	}
+	for (int id = 0; id < network_.roadwayCount(); ++id) {
+		Roadway& r = network_.roadway(id);
+		if (r.kind() == Roadway::SOURCE) {
+			initialEvents.push_back({0, id, 0, EventKind::CREATE_VEHICLE, 0,
+				0});
+		}
+	}
+}
+
+void Simulation::run(int totalTime, Scheduler scheduler, int partitions,
+		Synchronization synchronization) {
+	if (steadyBatch > 0 && (scheduler == STEPPED || partitions > 1)) {
+		throw std::runtime_error("o regime permanente só é detectado com "
+			"heap ou calendar, em uma partição");
+	}
+	endTime_ = totalTime;
+	if (scheduler == STEPPED) {
+		TimeSteppedEngine engine(network_);
+		engine.run(initialEvents, totalTime);
+		initialEvents.clear();
+	} else if (partitions > 1 && scheduler == CALENDAR) {
+		parallelLoop<CalendarQueue<EventRecord>>(totalTime, partitions,
+			synchronization);
+	} else if (partitions > 1) {
+		parallelLoop<BinaryHeap<EventRecord>>(totalTime, partitions,
+			synchronization);
+	} else if (scheduler == CALENDAR) {
+		loop<CalendarQueue<EventRecord>>(totalTime);
+	} else {
+		loop<BinaryHeap<EventRecord>>(totalTime);
+	}
+}
+
+/**
+ * Pending events are kept ordered by time (by tieBreak among events at
+ * the same time) in a Queue: BinaryHeap or CalendarQueue.
+ */
+template<typename Queue>
+void Simulation::loop(int totalTime) {
+	Queue events;
+
+	for (auto& e : initialEvents) {
+		events.push(e.time, tieBreak(e), e);
+	}
+	initialEvents.clear();
+
+	EventSink newEvents;
+	TraceBuffer trace(trace_.get());
+	std::unique_ptr<MetricsExporter> metrics;
+	int nextMetrics = INT_MAX;
+	if (metricsInterval > 0) {
+		metrics.reset(new MetricsExporter(metricsPath, network_));
+		nextMetrics = startTime + metricsInterval;
+	}
+	peakEvents_ = std::max(peakEvents_, events.size());
+	int nextCheckpoint = checkpointInterval > 0 ?
+		startTime + checkpointInterval : INT_MAX;
+	int nextObservation = steadyBatch > 0 ? startTime + steadyBatch : INT_MAX;
+	exitsLeft = leftExits();
+	while (!events.empty() && events.top_key() <= totalTime) {
+		// Every event up to the observation has run
+		bool steady = false;
+		while (!steady && events.top_key() > nextObservation) {
+			steady = observe(nextObservation);
+			nextObservation += steadyBatch;
+		}
+		if (steady) {
+			endTime_ = nextObservation - steadyBatch;
+			break;
+		}
+		if (events.top_key() > nextMetrics) {
+			// Same counters at every multiple up to top: publish the last
+			nextMetrics += (events.top_key() - 1 - nextMetrics) /
+				metricsInterval * metricsInterval;
+			metrics->publish(nextMetrics, eventsProcessed_, events.size());
+			nextMetrics += metricsInterval;
+		}
+		if (events.top_key() > nextCheckpoint) {
+			// Every event up to the last multiple before top has run
+			int skipped = (events.top_key() - 1 - nextCheckpoint) /
+				checkpointInterval;
+			nextCheckpoint += skipped * checkpointInterval;
+			checkpoint(events, nextCheckpoint);
+			nextCheckpoint += checkpointInterval;
+		}
+		auto currentEvent = events.pop();
+
+		auto outcome = dispatch(currentEvent, network_, newEvents);
+		trace.add(currentEvent, outcome);
+		eventsProcessed_++;
+
+		for (auto i = 0; i < newEvents.size(); ++i) {
+			auto& e = newEvents[i];
+			events.push(e.time, tieBreak(e), e);
+		}
+		newEvents.clear();
+
+		if (events.size() > peakEvents_) {
+			peakEvents_ = events.size();
+		}
+	}
+	trace.flush();
+	if (metrics) {
+		metrics->publish(endTime_, eventsProcessed_, events.size(), true);
+	}
+
+	if (checkpointInterval > 0) {
+		checkpoint(events, endTime_);  // So the run can be extended
+	}
+}
+
+int Simulation::leftExits() const {
+	int left = 0;
+	for (int id = 0; id < network_.roadwayCount(); ++id) {
+		const Roadway& r = network_.roadway(id);
+		if (r.kind() == Roadway::EXIT) {
+			left += r.left();
+		}
+	}
+	return left;
+}
+
+/**
+ * @return Whether both series are precise enough to stop
+ */
+bool Simulation::observe(int time) {
+	int left = leftExits();
+	throughput_.add(left - exitsLeft);
+	exitsLeft = left;
+	occupancy_.add(network_.totalIn() - network_.totalOut());
+	if (warmupEnd_ < 0 && throughput_.warm() && occupancy_.warm()) {
+		warmupEnd_ = time;
+		for (int id = 0; id < network_.roadwayCount(); ++id) {
+			network_.roadway(id).restartStatistics(time);
+		}
+		throughput_ = SteadyState(steadyWidth);
+		occupancy_ = SteadyState(steadyWidth);
+		return false;
+	}
+	return warmupEnd_ >= 0 && throughput_.precise() && occupancy_.precise();
+}
+
+template<typename Queue>
+void Simulation::checkpoint(Queue& events, int time) {
+	Checkpoint state;
+	state.time = time;
+	state.eventsProcessed = eventsProcessed_;
+	state.peakEvents = peakEvents_;
+	state.events.reserve(events.size());
+	while (!events.empty()) {
+		state.events.push_back(events.pop());
+	}
+	for (auto& e : state.events) {
+		events.push(e.time, tieBreak(e), e);
+	}
+	state.write(checkpointPath, network_, networkKey_);
+}
+
+template<typename Queue>
+void Simulation::parallelLoop(int totalTime, int partitions,
+		Synchronization synchronization) {
+	if (synchronization == OPTIMISTIC) {
+		TimeWarpEngine engine(network_, partitions);
+		engine.run<Queue>(initialEvents, totalTime, trace_.get());
+		peakEvents_ = std::max(peakEvents_, engine.peakEvents());
+		eventsProcessed_ += engine.eventsProcessed();
+		eventsRolledBack_ += engine.eventsRolledBack();
+	} else {
+		ParallelEngine engine(network_, partitions);
+		engine.run<Queue>(initialEvents, totalTime, trace_.get());
+		peakEvents_ = std::max(peakEvents_, engine.peakEvents());
+		eventsProcessed_ += engine.eventsProcessed();
+	}
+	initialEvents.clear();
+}
+
+void Simulation::checkpointEvery(int interval, const std::string& path) {
+	checkpointInterval = interval;
+	checkpointPath = path;
+}
+
+int Simulation::resume(const std::string& path) {
+	Checkpoint state;
+	state.read(path, network_, networkKey_);
+	initialEvents = std::move(state.events);
+	startTime = state.time;
+	eventsProcessed_ = state.eventsProcessed;
+	peakEvents_ = state.peakEvents;
+	return startTime;
+}
+
+void Simulation::traceTo(const std::string& path) {
+	trace_.reset(new TraceFile(path, description_));
+}
+
+void Simulation::metricsEvery(int interval, const std::string& path) {
+	metricsInterval = interval;
+	metricsPath = path;
+}
+
+void Simulation::stopWhenSteady(int batch, double relativeWidth) {
+	if (batch < 1) {
+		throw std::runtime_error("lote de observações menor que 1 s");
+	}
+	throughput_ = SteadyState(relativeWidth);
+	occupancy_ = SteadyState(relativeWidth);
+	steadyBatch = batch;
+	steadyWidth = relativeWidth;
+	warmupEnd_ = -1;
+}
+
+const Network& Simulation::network() const {
+	return network_;
+}
+
+int Simulation::endTime() const {
+	return endTime_;
+}
+
+int Simulation::warmupEnd() const {
+	return warmupEnd_;
+}
+
+Estimate Simulation::throughput() const {
+	return throughput_.estimate();
+}
+
+Estimate Simulation::occupancy() const {
+	return occupancy_.estimate();
+}
+
+std::size_t Simulation::peakEvents() const {
+	return peakEvents_;
+}
+
+std::uint64_t Simulation::eventsProcessed() const {
+	return eventsProcessed_;
+}
+
+std::uint64_t Simulation::eventsRolledBack() const {
+	return eventsRolledBack_;
+}
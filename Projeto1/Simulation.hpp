@@ -0,0 +1,161 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Event.hpp"
+#include "Network.hpp"
+#include "Random.hpp"
+#include "SteadyState.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief One independent run of the traffic simulation
+ *
+ * Owns its Network (and therefore its counters and random engine), so
+ * several simulations can run at the same time in different threads.
+ */
+class Simulation {
+public:
+	// Pending-events queue backend; STEPPED: no events, steps of one
+	// second over all roadways (see TimeSteppedEngine)
+	enum Scheduler { HEAP, CALENDAR, STEPPED };
+	enum Synchronization { CONSERVATIVE, OPTIMISTIC };  // Of partitions
+
+private:
+	std::string description_;
+	Network network_;
+	std::vector<EventRecord> initialEvents;
+	std::size_t peakEvents_ = 0;
+	std::uint64_t eventsProcessed_ = 0;
+	std::uint64_t eventsRolledBack_ = 0;
+	std::uint64_t networkKey_;  // Checks checkpoints (see Checkpoint)
+	int startTime = 0;  // Of the run: 0, or the checkpoint's time
+	int checkpointInterval = 0;  // 0: no checkpoints
+	std::string checkpointPath;
+	std::unique_ptr<TraceFile> trace_;  // nullptr: no trace
+	int metricsInterval = 0;  // 0: no live metrics
+	std::string metricsPath;
+	int steadyBatch = 0;  // Seconds between observations; 0: none
+	double steadyWidth = 0;
+	SteadyState throughput_, occupancy_;  // Observed every steadyBatch
+	int exitsLeft = 0;  // Vehicles out of the exits at the last one
+	int warmupEnd_ = -1, endTime_ = 0;
+
+	int leftExits() const;
+	bool observe(int time);
+	template<typename Queue>
+	void loop(int totalTime);
+	template<typename Queue>
+	void checkpoint(Queue& events, int time);
+	template<typename Queue>
+	void parallelLoop(int totalTime, int partitions,
+		Synchronization synchronization);
+
+public:
+	/**
+	 * @brief Builds the network, its light plans, routes and initial
+	 * events
+	 *
+	 * Every source creates its first vehicle at time 0. Fixed-time
+	 * lights need no events: they follow their intersection's phase
+	 * plan. Adaptive ones get their first decision at the end of the
+	 * first phase (see LightController).
+	 *
+	 * @param description Network description (see Network)
+	 * @param semaphFrequency Default time (s) between two light changes
+	 * @throws std::runtime_error on an invalid description or plan
+	 * @param random Random engine (stream) of this simulation
+	 */
+	Simulation(const std::string& description, int semaphFrequency,
+		const Random& random);
+
+	/**
+	 * @brief Runs the events up to (and including) totalTime
+	 *
+	 * @param partitions More than 1: runs in parallel, with the
+	 *        intersections split in that many partitions (see
+	 *        ParallelEngine and TimeWarpEngine); the results are the same.
+	 *        Ignored by STEPPED, which has no events.
+	 * @throws std::runtime_error for STEPPED with adaptive lights or
+	 *         demand, and for STEPPED or partitions after stopWhenSteady()
+	 */
+	void run(int totalTime, Scheduler scheduler = HEAP, int partitions = 1,
+		Synchronization synchronization = CONSERVATIVE);
+
+	/**
+	 * @brief Writes a checkpoint to path every interval simulated seconds
+	 * of the next run, and once more when it ends
+	 *
+	 * Each one replaces the previous one. Only HEAP and CALENDAR with one
+	 * partition write checkpoints.
+	 */
+	void checkpointEvery(int interval, const std::string& path);
+
+	/**
+	 * @brief Keeps a snapshot of the next run in path, taken every
+	 * interval simulated seconds and written from another thread (see
+	 * MetricsExporter)
+	 *
+	 * Only HEAP and CALENDAR with one partition publish snapshots.
+	 */
+	void metricsEvery(int interval, const std::string& path);
+
+	/**
+	 * @brief Makes the next run stop, before its total time, once the
+	 * network is in steady state and its means are known well enough
+	 *
+	 * Every batch simulated seconds, the vehicles that left the exits in
+	 * the batch (throughput) and the vehicles inside (occupancy) are
+	 * observed (see SteadyState). When both have left their warm-up, the
+	 * statistics of every roadway and the two series restart, so they
+	 * leave the empty network out and cover the same seconds; the run
+	 * stops when both estimates, from then on, are within relativeWidth.
+	 * Only HEAP and CALENDAR with one partition.
+	 *
+	 * @throws std::runtime_error if batch or relativeWidth isn't positive
+	 */
+	void stopWhenSteady(int batch, double relativeWidth);
+
+	/**
+	 * @brief Goes back to the state saved in a checkpoint, before run()
+	 *
+	 * The checkpoint must come from a simulation of the same description
+	 * and frequency. run() then goes on from there, with any engine but
+	 * STEPPED, and gives the same results as a run that never stopped.
+	 *
+	 * @return Time of the checkpoint
+	 * @throws std::runtime_error if the checkpoint can't be used (the
+	 *         simulation may then be left half restored)
+	 */
+	int resume(const std::string& path);
+
+	/**
+	 * @brief Writes every event the next runs handle to a trace (see
+	 * TraceFile)
+	 *
+	 * STEPPED has no events and writes nothing. With OPTIMISTIC, only
+	 * events that are never rolled back are written.
+	 *
+	 * @throws std::runtime_error if the file can't be created
+	 */
+	void traceTo(const std::string& path);
+
+	const Network& network() const;
+	int endTime() const;  // Time the last run stopped at
+	int warmupEnd() const;  // Statistics restart time; -1: never warm
+	Estimate throughput() const;  // Vehicles out per batch
+	Estimate occupancy() const;  // Vehicles inside
+	std::size_t peakEvents() const;  // Peak number of pending events
+	std::uint64_t eventsProcessed() const;  // Events run by the main loop
+	std::uint64_t eventsRolledBack() const;  // Run, then undone (optimistic)
+};
+
+#endif  // SIMULATION_HPP
@@ -0,0 +1,214 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include "Network.hpp"
+
+Estimate Estimate::of(const std::vector<double>& sample) {
+	// Student's t (two-sided, 95%) for 1..30 degrees of freedom
+	static const double T95[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+		2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101,
+		2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052,
+		2.048, 2.045, 2.042};
+
+	Estimate e;
+	auto n = sample.size();
+	if (n == 0) {
+		return e;
+	}
+
+	// Welford's online mean and variance
+	double m2 = 0;
+	for (auto i = 0u; i < n; ++i) {
+		double delta = sample[i] - e.mean;
+		e.mean += delta / (i + 1);
+		m2 += delta * (sample[i] - e.mean);
+	}
+	if (n > 1) {
+		double t = n - 1 <= 30 ? T95[n - 2] : 1.960;
+		e.halfWidth = t * std::sqrt(m2 / (n - 1) / n);
+	}
+	return e;
+}
+
+Histogram::Histogram(int width) : width_(width) {}
+
+void Histogram::add(int value, long long weight) {
+	int i = value / width_;
+	counts[std::min(std::max(i, 0), BUCKETS - 1)] += weight;
+}
+
+int Histogram::width() const {
+	return width_;
+}
+
+long long Histogram::bucket(int i) const {
+	return counts[i];
+}
+
+QueueStatistics::QueueStatistics() : lengths_(1), waits_(WAIT_WIDTH) {}
+
+void QueueStatistics::change(int time, int delta) {
+	lengths_.add(length, time - lastChange);
+	area += static_cast<long long>(length) * (time - lastChange);
+	lastChange = time;
+	length += delta;
+	maxLength_ = std::max(maxLength_, length);
+}
+
+void QueueStatistics::waited(int seconds) {
+	waits_.add(seconds);
+	waitTotal += seconds;
+	waitCount++;
+}
+
+void QueueStatistics::restart(int time) {
+	start_ = lastChange = time;
+	maxLength_ = length;
+	area = waitTotal = waitCount = 0;
+	lengths_ = Histogram(1);
+	waits_ = Histogram(WAIT_WIDTH);
+}
+
+int QueueStatistics::start() const {
+	return start_;
+}
+
+long long QueueStatistics::departures() const {
+	return waitCount;
+}
+
+int QueueStatistics::maxLength() const {
+	return maxLength_;
+}
+
+double QueueStatistics::averageLength(int endTime) const {
+	if (endTime <= start_) {
+		return length;
+	}
+	return (area + static_cast<double>(length) * (endTime - lastChange)) /
+		(endTime - start_);
+}
+
+double QueueStatistics::averageWait() const {
+	return waitCount > 0 ? static_cast<double>(waitTotal) / waitCount : 0;
+}
+
+Histogram QueueStatistics::lengths(int endTime) const {
+	Histogram h = lengths_;
+	h.add(length, endTime - lastChange);
+	return h;
+}
+
+const Histogram& QueueStatistics::waits() const {
+	return waits_;
+}
+
+namespace {
+
+const char* kindName(Roadway::Kind kind) {
+	switch (kind) {
+	case Roadway::SOURCE:
+		return "source";
+	case Roadway::CENTRAL:
+		return "central";
+	default:
+		return "exit";
+	}
+}
+
+double perHour(const QueueStatistics& s, int endTime) {
+	int seconds = endTime - s.start();
+	return seconds > 0 ? s.departures() * 3600.0 / seconds : 0;
+}
+
+}  // namespace
+
+std::string quoted(const std::string& text) {
+	std::string q = "\"";
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			q += '\\';
+			q += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char escape[7];
+			snprintf(escape, sizeof escape, "\\u%04x", unsigned(c));
+			q += escape;
+		} else {
+			q += c;
+		}
+	}
+	return q + "\"";
+}
+
+void writeStatisticsCsv(std::ostream& out, const Network& network,
+		int endTime) {
+	out << "roadway,kind,entered,left,in,blocked,throughput_per_hour,"
+		"avg_queue,max_queue,avg_wait";
+	for (int i = 0; i < Histogram::BUCKETS; ++i) {
+		out << ",queue_" << i;
+	}
+	for (int i = 0; i < Histogram::BUCKETS; ++i) {
+		out << ",wait_" << i * QueueStatistics::WAIT_WIDTH;
+	}
+	out << "\n";
+
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		const Roadway& r = network.roadway(id);
+		const QueueStatistics& s = r.statistics();
+		out << network.name(id) << "," << kindName(r.kind()) << ","
+			<< r.entered() << "," << r.left() << "," << r.areIn() << ","
+			<< r.blocked() << "," << perHour(s, endTime) << ","
+			<< s.averageLength(endTime) << "," << s.maxLength() << ","
+			<< s.averageWait();
+		Histogram lengths = s.lengths(endTime);
+		for (int i = 0; i < Histogram::BUCKETS; ++i) {
+			out << "," << lengths.bucket(i);
+		}
+		for (int i = 0; i < Histogram::BUCKETS; ++i) {
+			out << "," << s.waits().bucket(i);
+		}
+		out << "\n";
+	}
+}
+
+void writeStatisticsJson(std::ostream& out, const Network& network,
+		int endTime) {
+	auto histogram = [&](const Histogram& h) {
+		out << "{\"width\": " << h.width() << ", \"counts\": [";
+		for (int i = 0; i < Histogram::BUCKETS; ++i) {
+			out << (i > 0 ? ", " : "") << h.bucket(i);
+		}
+		out << "]}";
+	};
+
+	int start = network.roadwayCount() > 0 ?
+		network.roadway(0).statistics().start() : 0;
+	out << "{\n  \"time\": " << endTime << ",\n  \"start\": " << start
+		<< ",\n  \"roadways\": [\n";
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		const Roadway& r = network.roadway(id);
+		const QueueStatistics& s = r.statistics();
+		out << "    {\"name\": " << quoted(network.name(id))
+			<< ", \"kind\": \"" << kindName(r.kind()) << "\", \"entered\": "
+			<< r.entered()
+			<< ", \"left\": " << r.left() << ", \"in\": " << r.areIn()
+			<< ", \"blocked\": " << r.blocked()
+			<< ", \"throughput_per_hour\": " << perHour(s, endTime)
+			<< ", \"avg_queue\": " << s.averageLength(endTime)
+			<< ", \"max_queue\": " << s.maxLength()
+			<< ", \"avg_wait\": " << s.averageWait()
+			<< ",\n     \"queue_seconds\": ";
+		histogram(s.lengths(endTime));
+		out << ",\n     \"wait_vehicles\": ";
+		histogram(s.waits());
+		out << "}" << (id + 1 < network.roadwayCount() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
@@ -0,0 +1,90 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Network;
+
+/**
+ * @brief Mean and 95% confidence interval of a sample
+ */
+struct Estimate {
+	double mean = 0;
+	double halfWidth = 0;  // CI is mean +- halfWidth
+
+	static Estimate of(const std::vector<double>& sample);
+};
+
+/**
+ * @brief Counts values in fixed-width buckets; the last one takes the rest
+ */
+class Histogram {
+public:
+	static const int BUCKETS = 32;
+
+	explicit Histogram(int width = 1);
+	void add(int value, long long weight = 1);
+	int width() const;
+	long long bucket(int i) const;
+
+private:
+	int width_;
+	long long counts[BUCKETS] = {};
+};
+
+/**
+ * @brief Queue of one roadway over time: length and waiting times
+ *
+ * Updated on every change of the queue, in O(1). Lengths are weighted
+ * by the seconds the queue had them. Everything is counted from start(),
+ * 0 unless restarted after a warm-up (see SteadyState).
+ */
+class QueueStatistics {
+public:
+	static const int WAIT_WIDTH = 10;  // Seconds per waiting-time bucket
+
+	QueueStatistics();
+	void change(int time, int delta);  // Queue length += delta at time
+	void waited(int seconds);  // A vehicle left after waiting
+	void restart(int time);  // Forgets everything before time
+
+	int start() const;
+	long long departures() const;  // Vehicles that left since start()
+	int maxLength() const;
+	double averageLength(int endTime) const;
+	double averageWait() const;  // Seconds, over the vehicles that left
+	Histogram lengths(int endTime) const;  // Seconds spent at each length
+	const Histogram& waits() const;  // Vehicles by seconds waited
+
+private:
+	int start_ = 0, lastChange = 0, length = 0, maxLength_ = 0;
+	long long area = 0;  // Length times seconds, up to lastChange
+	long long waitTotal = 0, waitCount = 0;
+	Histogram lengths_, waits_;
+};
+
+/**
+ * @brief text as a JSON string: between quotes, with '"', '\\' and the
+ * control characters escaped
+ */
+std::string quoted(const std::string& text);
+
+/**
+ * @brief Writes the statistics of every roadway, one line (CSV) or object
+ * (JSON) per roadway
+ *
+ * @param endTime Time the run stopped at; averages and throughputs are
+ *        taken from the start of the statistics up to it
+ */
+void writeStatisticsCsv(std::ostream& out, const Network& network,
+	int endTime);
+void writeStatisticsJson(std::ostream& out, const Network& network,
+	int endTime);
+
+#endif  // STATISTICS_HPP
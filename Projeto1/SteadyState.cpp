@@ -0,0 +1,85 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "SteadyState.hpp"
+#include <cmath>
+#include <stdexcept>
+
+SteadyState::SteadyState(double relativeWidth) :
+	relativeWidth(relativeWidth) {
+	if (!(relativeWidth > 0)) {
+		throw std::runtime_error("largura relativa do intervalo deve ser "
+			"positiva");
+	}
+}
+
+void SteadyState::add(double observation) {
+	partial += observation;
+	if (++observations_ % MSER_BATCH == 0) {
+		groups.push_back(partial / MSER_BATCH);
+		partial = 0;
+		truncate();
+	}
+}
+
+void SteadyState::truncate() {
+	// Suffix sums, from the last group back to the first
+	int m = groups.size();
+	double sum = 0, squares = 0, best = -1;
+	cut = 0;
+	for (int d = m - 1; d >= 0; --d) {
+		sum += groups[d];
+		squares += groups[d] * groups[d];
+		int n = m - d;  // Groups after a cut of d
+		if (n < 2 || d > m / 2) {
+			continue;
+		}
+		double deviations = squares - sum * sum / n;
+		double mser = deviations / (double(n) * n);
+		if (best < 0 || mser <= best) {
+			best = mser;
+			cut = d;
+		}
+	}
+}
+
+int SteadyState::observations() const {
+	return observations_;
+}
+
+int SteadyState::warmup() const {
+	return cut * MSER_BATCH;
+}
+
+bool SteadyState::warm() const {
+	int m = groups.size();
+	return m - cut >= BATCHES && 2 * cut < m;
+}
+
+Estimate SteadyState::estimate() const {
+	int m = groups.size();
+	int size = (m - cut) / BATCHES;  // Groups in a batch
+	if (size < 1) {
+		return Estimate();
+	}
+	std::vector<double> means;
+	for (int first = m - BATCHES * size; first < m; first += size) {
+		double total = 0;
+		for (int j = first; j < first + size; ++j) {
+			total += groups[j];
+		}
+		means.push_back(total / size);
+	}
+	return Estimate::of(means);
+}
+
+bool SteadyState::precise() const {
+	if (!warm()) {
+		return false;
+	}
+	// A zero mean has no relative width: 0 <= 0 would stop a series
+	// that never moved, e.g. no vehicles yet
+	Estimate e = estimate();
+	return e.mean != 0 && e.halfWidth <= relativeWidth * std::fabs(e.mean);
+}
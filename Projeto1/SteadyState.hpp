@@ -0,0 +1,69 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef STEADY_STATE_HPP
+#define STEADY_STATE_HPP
+
+#include <vector>
+#include "Statistics.hpp"
+
+/**
+ * @brief Finds, as observations come, where a series leaves its warm-up
+ * and how precisely its steady-state mean is known
+ *
+ * The warm-up is cut by MSER-5: observations are averaged in groups of
+ * MSER_BATCH, and the cut is the number of groups d that minimizes the
+ * squared standard error of the groups after it,
+ *   sum((g[j] - mean)^2, j > d) / (m - d)^2,
+ * only looked for in the first half (a minimum in the second half means
+ * the series still drifts). The mean of what is left is estimated by
+ * batch means: BATCHES batches of equal size, whose means are taken as
+ * independent.
+ *
+ * Adding an observation is O(1); a completed group recomputes the cut in
+ * O(groups), with suffix sums.
+ */
+class SteadyState {
+public:
+	static const int MSER_BATCH = 5;  // Observations averaged in a group
+	static const int BATCHES = 20;  // Of the batch-means estimate
+
+private:
+	double relativeWidth;
+	std::vector<double> groups;  // Means of the complete groups
+	double partial = 0;  // Sum of the incomplete group
+	int observations_ = 0;
+	int cut = 0;  // Groups of warm-up (MSER-5)
+
+	void truncate();
+
+public:
+	/**
+	 * @param relativeWidth Half-width of the 95% interval, over the
+	 *        mean, that precise() asks for
+	 */
+	explicit SteadyState(double relativeWidth = 0.05);
+
+	void add(double observation);
+
+	int observations() const;
+	int warmup() const;  // Observations of warm-up, by the current cut
+
+	/**
+	 * @brief Whether the cut is in the first half and leaves at least
+	 * BATCHES groups after it
+	 */
+	bool warm() const;
+
+	/**
+	 * @brief Batch-means estimate of the mean after the warm-up (the
+	 * oldest groups left over by the batches are also dropped)
+	 */
+	Estimate estimate() const;
+
+	// warm(), the mean isn't 0, and the interval is narrow enough
+	bool precise() const;
+};
+
+#endif  // STEADY_STATE_HPP
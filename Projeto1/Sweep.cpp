@@ -0,0 +1,246 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Sweep.hpp"
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "Statistics.hpp"
+
+namespace {
+
+double mean(const std::vector<double>& sample) {
+	return Estimate::of(sample).mean;
+}
+
+}  // namespace
+
+Sweep::Sweep(const std::string& description, int semaphFrequency,
+		int threads, std::uint64_t masterSeed) :
+	description(description),
+	semaphFrequency(semaphFrequency),
+	threads(threads > 0 ? threads : std::thread::hardware_concurrency()),
+	masterSeed(masterSeed) {
+	if (this->threads < 1) {
+		this->threads = 1;
+	}
+
+	Network network;
+	std::istringstream in(description);
+	network.load(in);
+	network.planLights(semaphFrequency);
+	for (int i = 0; i < network.intersectionCount(); ++i) {
+		auto& intersection = network.intersection(i);
+		names.push_back(intersection.name);
+		plans.push_back(network.plan(i).phases());
+		approaches.emplace_back();
+		for (int k = 0; k < intersection.semaphoreCount &&
+				k < PhasePlan::MAX_APPROACHES; ++k) {
+			const std::string& name =
+				network.semaphoreName(intersection.firstSemaphore + k);
+			approaches.back().push_back(name.substr(intersection.name.size() +
+				1));
+		}
+	}
+}
+
+std::string Sweep::describe(const std::vector<int>& cycles) const {
+	// Later phases lines replace the plans of the description
+	std::ostringstream out;
+	out << description << "\n";
+	for (auto i = 0u; i < names.size(); ++i) {
+		long long total = 0;
+		for (auto& phase : plans[i]) {
+			total += phase.duration;
+		}
+		out << "phases " << names[i];
+		for (auto& phase : plans[i]) {
+			long long seconds = (phase.duration * 2LL * cycles[i] + total) /
+				(2 * total);
+			out << " " << std::max(1LL, seconds) << ":";
+			if (phase.green == 0) {
+				out << "-";
+			}
+			const char* separator = "";
+			for (auto k = 0u; k < approaches[i].size(); ++k) {
+				if (phase.opens(k)) {
+					out << separator << approaches[i][k];
+					separator = "+";
+				}
+			}
+		}
+		out << "\n";
+	}
+	return out.str();
+}
+
+void Sweep::grid(int min, int max, int step) {
+	if (min < 1 || max < min || step < 1) {
+		throw std::runtime_error("intervalo de ciclos inválido");
+	}
+	for (int cycle = min; cycle <= max; cycle += step) {
+		Candidate c;
+		c.cycles.assign(names.size(), cycle);
+		candidates.push_back(c);
+	}
+}
+
+void Sweep::random(int count, int min, int max, int step) {
+	if (min < 1 || max < min || step < 1) {
+		throw std::runtime_error("intervalo de ciclos inválido");
+	}
+	int values = (max - min) / step + 1;
+	Random draws(~masterSeed);  // Apart from the replications' streams
+	for (int n = 0; n < count; ++n) {
+		Candidate c;
+		for (auto i = 0u; i < names.size(); ++i) {
+			c.cycles.push_back(min + step * int(draws.uniform() * values));
+		}
+		bool known = false;
+		for (auto& other : candidates) {
+			known = known || other.cycles == c.cycles;
+		}
+		if (!known) {
+			candidates.push_back(c);
+		}
+	}
+}
+
+void Sweep::run(int totalTime, int replications,
+		Simulation::Scheduler scheduler) {
+	if (candidates.empty()) {
+		throw std::logic_error("Sweep::run without candidates");
+	}
+	std::vector<std::string> descriptions;
+	std::vector<int> alive;
+	for (auto c = 0u; c < candidates.size(); ++c) {
+		descriptions.push_back(describe(candidates[c].cycles));
+		alive.push_back(c);
+	}
+
+	std::vector<Random> streams;  // Replication i of every candidate
+	Random stream(masterSeed);
+	int target = std::max(1, replications);
+	for (int round = 1; ; ++round) {
+		while (int(streams.size()) < target) {
+			streams.push_back(stream);
+			stream.longJump();
+		}
+
+		// The replications each candidate left still lacks
+		struct Task {
+			int candidate, replication;
+		};
+		std::vector<Task> tasks;
+		for (int c : alive) {
+			auto& out = candidates[c].out;
+			for (int r = out.size(); r < target; ++r) {
+				tasks.push_back({c, r});
+			}
+			out.resize(target);
+			candidates[c].rounds = round;
+		}
+
+		std::atomic<int> next(0);
+		int count = tasks.size();
+		auto worker = [&]() {
+			for (int t = next++; t < count; t = next++) {
+				auto& task = tasks[t];
+				Simulation simulation(descriptions[task.candidate],
+					semaphFrequency, streams[task.replication]);
+				simulation.run(totalTime, scheduler);
+				candidates[task.candidate].out[task.replication] =
+					simulation.network().totalOut();
+			}
+		};
+		std::vector<std::thread> pool;
+		for (int t = 1; t < std::min(threads, count); ++t) {
+			pool.emplace_back(worker);
+		}
+		worker();
+		for (auto& t : pool) {
+			t.join();
+		}
+
+		if (alive.size() == 1) {
+			break;
+		}
+		// Same replications for all: the means are a paired comparison
+		std::stable_sort(alive.begin(), alive.end(), [&](int a, int b) {
+			return mean(candidates[a].out) > mean(candidates[b].out);
+		});
+		alive.resize((alive.size() + 1) / 2);
+		if (alive.size() == 1) {
+			break;
+		}
+		target *= 2;
+	}
+	best_ = alive[0];
+}
+
+const Sweep::Candidate& Sweep::best() const {
+	if (best_ < 0) {
+		throw std::logic_error("Sweep::best before run");
+	}
+	return candidates[best_];
+}
+
+void Sweep::print(std::ostream& out) const {
+	std::vector<int> order;
+	for (auto c = 0u; c < candidates.size(); ++c) {
+		order.push_back(c);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		auto& x = candidates[a];
+		auto& y = candidates[b];
+		if (x.rounds != y.rounds) {
+			return x.rounds > y.rounds;
+		}
+		return mean(x.out) > mean(y.out);
+	});
+
+	out << "--------------------\n"
+	<< "   RELATÓRIO DA VARREDURA\n"
+	<< "Candidatos: " << candidates.size() << " (semente " << masterSeed
+	<< ")\nIntervalos de confiança de 95%\n\n"
+	<< "rodadas replicações  saíram              ciclos\n";
+	for (int c : order) {
+		auto& candidate = candidates[c];
+		Estimate left = Estimate::of(candidate.out);
+		std::ostringstream estimate;
+		estimate << left.mean << " +- " << left.halfWidth;
+		out.width(7);
+		out << candidate.rounds << " ";
+		out.width(11);
+		out << candidate.out.size() << "  ";
+		out.width(18);
+		out << std::left << estimate.str() << std::right;
+		for (int cycle : candidate.cycles) {
+			out << " " << cycle;
+		}
+		out << "\n";
+	}
+
+	if (best_ >= 0) {
+		// Paired over the replications both ran: common random numbers
+		// make this interval narrower than the two apart
+		auto& first = candidates[best_];
+		if (order.size() > 1) {
+			auto& second = candidates[order[order[0] == best_ ? 1 : 0]];
+			std::vector<double> difference;
+			for (auto r = 0u; r < second.out.size(); ++r) {
+				difference.push_back(first.out[r] - second.out[r]);
+			}
+			Estimate gap = Estimate::of(difference);
+			out << "\nVantagem sobre o segundo: " << gap.mean << " +- "
+				<< gap.halfWidth << "\n";
+		}
+		out << "\nMelhor configuração:\n";
+		std::string lines = describe(first.cycles);
+		out << lines.substr(description.size() + 1);
+	}
+	out << "--------------------\n" << std::endl;
+}
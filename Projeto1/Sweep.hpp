@@ -0,0 +1,90 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Simulation.hpp"
+
+/**
+ * @brief Searches the light cycles that get the most vehicles out
+ *
+ * A candidate gives each intersection a cycle length; its phase plan
+ * (see PhasePlan) is stretched to it, keeping the share of each phase.
+ * Candidates are run on all cores in rounds (successive halving): every
+ * round runs more replications of the candidates left and drops the
+ * worse half by mean Network::totalOut(), until one is left.
+ *
+ * Replication i of every candidate uses the same random stream (common
+ * random numbers, seeded as in Replications), and each roadway draws
+ * from its own stream, so candidates are compared on the same arrivals
+ * and differences come from the lights, not from the luck of the draw.
+ */
+class Sweep {
+public:
+	struct Candidate {
+		std::vector<int> cycles;  // By intersection
+		std::vector<double> out;  // totalOut of each replication run
+		int rounds = 0;  // Rounds it went through
+	};
+
+private:
+	std::string description;  // Network description
+	int semaphFrequency, threads;
+	std::uint64_t masterSeed;
+	std::vector<std::string> names;  // Of the intersections
+	std::vector<std::vector<PhasePlan::Phase>> plans;  // As described
+	std::vector<std::vector<std::string>> approaches;  // Names, by plan bit
+	std::vector<Candidate> candidates;
+	int best_ = -1;
+
+	std::string describe(const std::vector<int>& cycles) const;
+
+public:
+	/**
+	 * @param description Network description (see Network)
+	 * @param semaphFrequency Default green of the plans (see Network)
+	 * @param threads Worker threads (0: one per core)
+	 * @param masterSeed Seed of the replications and of random candidates
+	 * @throws std::runtime_error on an invalid description
+	 */
+	Sweep(const std::string& description, int semaphFrequency, int threads,
+		std::uint64_t masterSeed);
+
+	/**
+	 * @brief Adds the grid min, min + step... max, with the same cycle at
+	 * every intersection
+	 */
+	void grid(int min, int max, int step);
+
+	/**
+	 * @brief Adds count candidates whose cycles are drawn, intersection
+	 * by intersection, from the same grid
+	 */
+	void random(int count, int min, int max, int step);
+
+	/**
+	 * @brief Runs the rounds
+	 *
+	 * @param replications Of each candidate in the first round; doubles
+	 *        every round
+	 * @throws std::logic_error if there are no candidates
+	 */
+	void run(int totalTime, int replications,
+		Simulation::Scheduler scheduler = Simulation::HEAP);
+
+	const Candidate& best() const;
+
+	/**
+	 * @brief Candidates by rounds and mean, then the phases lines of the
+	 * best, to paste in the network description
+	 */
+	void print(std::ostream& out) const;
+};
+
+#endif  // SWEEP_HPP
@@ -0,0 +1,288 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "TimeSteppedEngine.hpp"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+TimeSteppedEngine::TimeSteppedEngine(Network& network) :
+	network(network),
+	roadways(network.roadwayCount()),
+	kinds(roadways),
+	travel(roadways),
+	semaphore(roadways),
+	space(roadways),
+	in(roadways),
+	out(roadways),
+	blocked(roadways),
+	stopped(roadways, 0),
+	nextExit(roadways, -1),
+	moveWaiting(roadways, 0),
+	createWaiting(roadways, 0),
+	nextCreate(roadways, INT_MAX),
+	open(network.semaphoreCount()),
+	nextToggle(network.semaphoreCount(), INT_MAX) {
+	if (network.adaptive()) {
+		throw std::runtime_error("o modo em passos só tem semáforos de "
+			"tempo fixo");
+	}
+	if (network.routed()) {
+		throw std::runtime_error("o modo em passos não tem destinos");
+	}
+
+	// A roadway holds at most capacity / (smallest vehicle) vehicles
+	int smallest = Vehicle::SIZE_;
+	int slots = 0;
+	for (int id = 0; id < roadways; ++id) {
+		Roadway& r = network.roadway(id);
+		if (r.areIn() != 0) {
+			throw std::logic_error("TimeSteppedEngine needs an empty network");
+		}
+		Roadway::EntryState entry;
+		r.save(entry);
+		kinds[id] = r.kind();
+		travel[id] = r.timeToTravel();
+		semaphore[id] = r.getSemaphore().id();
+		space[id] = entry.size;
+		in[id] = entry.in;
+		out[id] = r.left();
+		blocked[id] = entry.blocked;
+		statistics.push_back(r.statistics());
+
+		int capacity = r.capacity() / smallest + 1;
+		vehicles.push_back(makeRing(capacity, slots));
+		leaving.push_back(makeRing(r.kind() == Roadway::CENTRAL ? capacity : 0,
+			slots));
+		if (r.kind() == Roadway::SOURCE) {
+			sources.push_back(id);
+		}
+		if (r.kind() != Roadway::EXIT) {
+			movers.push_back(id);
+		}
+	}
+	slotTime.resize(slots);
+	slotSize.resize(slots);
+}
+
+TimeSteppedEngine::Ring TimeSteppedEngine::makeRing(int capacity,
+		int& slots) {
+	Ring ring;
+	ring.base = slots;
+	ring.capacity = capacity;
+	slots += capacity;
+	return ring;
+}
+
+void TimeSteppedEngine::push(Ring& ring, int time, int size) {
+	int s = slot(ring, ring.count);
+	slotTime[s] = time;
+	slotSize[s] = size;
+	ring.count++;
+}
+
+void TimeSteppedEngine::pop(Ring& ring) {
+	if (++ring.head == ring.capacity) {
+		ring.head = 0;
+	}
+	ring.count--;
+}
+
+int TimeSteppedEngine::slot(const Ring& ring, int i) const {
+	// i < capacity: no need for a division
+	int k = ring.head + i;
+	return ring.base + (k < ring.capacity ? k : k - ring.capacity);
+}
+
+int TimeSteppedEngine::arrivalOf(int id, int slot) const {
+	// Central roadways queue vehicles when they get to the semaphore,
+	// the others as soon as they enter
+	return slotTime[slot] + (kinds[id] == Roadway::CENTRAL ? travel[id] : 0);
+}
+
+void TimeSteppedEngine::changeLights(int time) {
+	if (time < nextLightChange || nextLightChange == INT_MAX) {
+		return;  // Most seconds: no light changes
+	}
+	// A mask over the array, without branches
+	for (auto s = 0u; s < open.size(); ++s) {
+		open[s] ^= std::uint8_t(nextToggle[s] == time);
+	}
+	// Only the lights that changed ask their plan for the next change
+	nextLightChange = INT_MAX;
+	for (auto s = 0u; s < open.size(); ++s) {
+		if (nextToggle[s] == time) {
+			nextToggle[s] = network.semaphore(s).nextChange(time);
+		}
+		nextLightChange = std::min(nextLightChange, nextToggle[s]);
+	}
+}
+
+void TimeSteppedEngine::letOut(int id, int time) {
+	Ring& ring = vehicles[id];
+	if (ring.count == 0 && leaving[id].count == 0) {
+		return;
+	}
+	if (kinds[id] == Roadway::EXIT) {
+		while (ring.count > 0 && slotTime[slot(ring, 0)] + travel[id] <= time) {
+			int first = slot(ring, 0);
+			space[id] += slotSize[first];
+			out[id]++;
+			statistics[id].change(time, -1);
+			statistics[id].waited(time - arrivalOf(id, first));
+			pop(ring);
+		}
+	} else {
+		Ring& left = leaving[id];
+		while (left.count > 0 && slotTime[slot(left, 0)] <= time) {
+			space[id] += slotSize[slot(left, 0)];
+			pop(left);
+		}
+	}
+}
+
+void TimeSteppedEngine::create(int id, int time) {
+	Source& source = static_cast<Source&>(network.roadway(id));
+	int size = source.nextVehicleSize();
+	if (size > space[id]) {
+		if (!createWaiting[id]) {
+			blocked[id]++;
+			createWaiting[id] = 1;
+		}
+		return;
+	}
+	createWaiting[id] = 0;
+
+	source.takeVehicleSize();
+	space[id] -= size;
+	in[id]++;
+	push(vehicles[id], time, size);
+	statistics[id].change(time, +1);
+	nextCreate[id] = source.nextEventsTime(time);
+}
+
+void TimeSteppedEngine::move(int id, int time) {
+	Ring& ring = vehicles[id];
+	if (ring.count == 0) {
+		return;
+	}
+	bool central = kinds[id] == Roadway::CENTRAL;
+	while (stopped[id] < ring.count &&
+			slotTime[slot(ring, stopped[id])] + travel[id] <= time) {
+		stopped[id]++;
+		if (central) {
+			statistics[id].change(time, +1);
+		}
+	}
+	if (stopped[id] == 0 || !open[semaphore[id]]) {
+		return;
+	}
+
+	while (stopped[id] > 0) {
+		if (nextExit[id] < 0) {
+			Roadway* exit = network.roadway(id).pickExit();
+			if (exit == nullptr) {
+				throw std::logic_error("TimeSteppedEngine: roadway without exits");
+			}
+			nextExit[id] = exit->id();
+		}
+		int next = nextExit[id];
+		int first = slot(ring, 0);
+		int size = slotSize[first];
+		if (size > space[next]) {
+			if (!moveWaiting[id]) {
+				blocked[next]++;
+				moveWaiting[id] = 1;
+			}
+			return;
+		}
+		moveWaiting[id] = 0;
+
+		space[next] -= size;
+		in[next]++;
+		push(vehicles[next], time, size);
+		if (kinds[next] != Roadway::CENTRAL) {
+			statistics[next].change(time, +1);
+		}
+
+		out[id]++;
+		statistics[id].change(time, -1);
+		statistics[id].waited(time - arrivalOf(id, first));
+		pop(ring);
+		stopped[id]--;
+		nextExit[id] = -1;
+		if (central) {
+			push(leaving[id], time + travel[id], size);
+		} else {
+			space[id] += size;
+		}
+	}
+}
+
+void TimeSteppedEngine::writeBack() {
+	for (int id = 0; id < roadways; ++id) {
+		Roadway& r = network.roadway(id);
+		Roadway::EntryState entry;
+		r.save(entry);
+		entry.size = space[id];
+		entry.in = in[id];
+		entry.blocked = blocked[id];
+		r.restore(entry);
+
+		Roadway::ExitState exit;
+		r.save(exit);
+		exit.out = out[id];
+		exit.stopped = stopped[id];
+		exit.nextExit = nextExit[id] >= 0 ? &network.roadway(nextExit[id]) :
+			nullptr;
+		exit.queue.clear();
+		const Ring& ring = vehicles[id];
+		int queued = kinds[id] == Roadway::CENTRAL ? stopped[id] : ring.count;
+		for (int i = 0; i < queued; ++i) {
+			int s = slot(ring, i);
+			auto v = Vehicle::withSize(slotSize[s]);
+			v.setArrival(arrivalOf(id, s));
+			exit.queue.push_back(v);
+		}
+		exit.statistics = statistics[id];
+		r.restore(exit);
+	}
+}
+
+void TimeSteppedEngine::run(const std::vector<EventRecord>& initialEvents,
+		int totalTime) {
+	int start = INT_MAX;
+	for (auto& e : initialEvents) {
+		if (e.kind == EventKind::CREATE_VEHICLE) {
+			nextCreate[e.target] = e.time;
+		} else {
+			throw std::logic_error("TimeSteppedEngine: initial event of "
+				"another kind");
+		}
+		start = std::min(start, e.time);
+	}
+	for (auto s = 0u; s < open.size(); ++s) {
+		open[s] = network.semaphore(s).open(start);
+		nextToggle[s] = network.semaphore(s).nextChange(start);
+		nextLightChange = std::min(nextLightChange, nextToggle[s]);
+	}
+
+	// long long: totalTime may be INT_MAX
+	for (long long t = start; t <= totalTime; ++t) {
+		int time = t;
+		changeLights(time);
+		for (int id = 0; id < roadways; ++id) {
+			letOut(id, time);
+		}
+		for (int id : sources) {
+			if (nextCreate[id] <= time) {
+				create(id, time);
+			}
+		}
+		for (int id : movers) {
+			move(id, time);
+		}
+	}
+	writeBack();
+}
@@ -0,0 +1,103 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef TIME_STEPPED_ENGINE_HPP
+#define TIME_STEPPED_ENGINE_HPP
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "Event.hpp"
+#include "Network.hpp"
+#include "Statistics.hpp"
+
+/**
+ * @brief Runs one simulation in steps of one second, without events
+ *
+ * When the network is saturated, almost every roadway has something to
+ * do every second, and sweeping all of them beats scheduling each thing
+ * on its own. The state lives in arrays indexed by roadway (or semaphore)
+ * id. The vehicles of a roadway are a ring of (entry time, size), in the
+ * order they entered. Every vehicle takes the same timeToTravel(), so the
+ * vehicles at the semaphore are always the first ones of the ring.
+ *
+ * Each second: the lights change (a mask over the semaphores, on the
+ * seconds some light does), exits let out the vehicles that got to their
+ * end and central roadways get back the space of the vehicles that left
+ * them, sources create vehicles, then every roadway with a green light
+ * moves its stopped vehicles, in id order, while their exits have space.
+ * A blocked roadway just tries again on the next step.
+ *
+ * The model is the event-driven one, discretized: a vehicle of a source
+ * gets to the semaphore timeToTravel() after it was created, and
+ * roadways blocked on the same exit go in id order rather than first
+ * come, first served. So the results agree with the other engines in
+ * the aggregate, not vehicle by vehicle. The random draws are the
+ * roadways' own, and the counters and statistics are written back into
+ * the roadways, so reports work the same.
+ */
+class TimeSteppedEngine {
+private:
+	struct Ring {  // Vehicles of a roadway, in a slice of the slot arrays
+		int base, capacity, head = 0, count = 0;
+	};
+
+	Network& network;
+	int roadways;
+	std::vector<int> sources, movers;  // Ids; movers: sources and centrals
+
+	// By roadway id
+	std::vector<std::uint8_t> kinds;
+	std::vector<int> travel, semaphore;
+	std::vector<int> space, in, out, blocked;
+	std::vector<int> stopped;  // First vehicles of the ring at the semaphore
+	std::vector<int> nextExit;  // Picked by the first stopped one; -1: none
+	// Found no space since the last success: moving out, creating
+	std::vector<std::uint8_t> moveWaiting, createWaiting;
+	std::vector<int> nextCreate;  // Sources; INT_MAX for the others
+	std::vector<QueueStatistics> statistics;
+	std::vector<Ring> vehicles;  // On the roadway
+	std::vector<Ring> leaving;  // Left a central, space not back yet
+
+	// Slots of the rings: entry time (or when the space gets back), size
+	std::vector<int> slotTime;
+	std::vector<std::uint8_t> slotSize;
+
+	// By semaphore id, from the phase plans
+	std::vector<std::uint8_t> open;
+	std::vector<int> nextToggle;  // INT_MAX: never changes
+	int nextLightChange = INT_MAX;  // Earliest of nextToggle
+
+	Ring makeRing(int capacity, int& slots);
+	void push(Ring& ring, int time, int size);
+	void pop(Ring& ring);
+	int slot(const Ring& ring, int i) const;  // Of the i-th vehicle
+	int arrivalOf(int id, int slot) const;  // When it joined the queue
+
+	void changeLights(int time);
+	void letOut(int id, int time);
+	void create(int id, int time);
+	void move(int id, int time);
+	void writeBack();  // Into the roadways and semaphores
+
+public:
+	/**
+	 * @throws std::logic_error if the network already has vehicles
+	 * @throws std::runtime_error if some lights are adaptive: they need
+	 *         the events of their controller; or if vehicles have
+	 *         destinations: its queues only keep sizes
+	 */
+	explicit TimeSteppedEngine(Network& network);
+
+	/**
+	 * @brief Runs the steps up to (and including) totalTime
+	 *
+	 * @param initialEvents Where the sources start (CREATE_VEHICLE; see
+	 *        Simulation)
+	 * @throws std::logic_error for an initial event of another kind
+	 */
+	void run(const std::vector<EventRecord>& initialEvents, int totalTime);
+};
+
+#endif  // TIME_STEPPED_ENGINE_HPP
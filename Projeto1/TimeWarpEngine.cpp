@@ -0,0 +1,455 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "TimeWarpEngine.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include "Barrier.hpp"
+#include "binary_heap.h"
+#include "calendar_queue.h"
+
+namespace {
+
+// Order in which events run: time, then tieBreak
+typedef std::pair<int, std::uint64_t> Key;
+
+Key keyOf(const EventRecord& e) {
+	return Key(e.time, tieBreak(e));
+}
+
+// Equal events are interchangeable, so an anti-message cancels any
+// pending event with the same identity
+typedef std::tuple<int, std::uint64_t, int, int> Identity;
+
+Identity identityOf(const EventRecord& e) {
+	return Identity(e.time, tieBreak(e), e.size, e.destination);
+}
+
+struct Message {
+	EventRecord event;
+	bool anti;  // Cancels the same event, sent before
+};
+
+struct Inbox {
+	std::mutex mutex;
+	std::vector<Message> messages;
+};
+
+/**
+ * @brief What the partitions share: inboxes, GVT rounds
+ */
+struct Shared {
+	std::vector<Inbox> inboxes;  // By partition
+	std::atomic<long> inFlight{0};  // Messages sent, not yet received
+	std::vector<int> nextTime;  // Earliest pending event, by partition
+	Barrier barrier;
+
+	explicit Shared(int n) : inboxes(n), nextTime(n, INT_MAX), barrier(n) {}
+};
+
+/**
+ * @brief One partition of a Time Warp run
+ */
+template<typename Queue>
+class LogicalProcess {
+public:
+	std::size_t peak = 0;
+	std::uint64_t processedCount = 0, rolledBack = 0, rollbacks = 0;
+
+	LogicalProcess(int id, Network& network, const Partitioning& partitioning,
+			Shared& shared, TraceFile* trace) :
+		id(id), network(network), partitioning(partitioning), shared(shared),
+		traced(trace) {}
+
+	void schedule(const EventRecord& e) {
+		pending.push(e.time, tieBreak(e), e);
+		peak = std::max(peak, pending.size());
+	}
+
+	void run(int totalTime) {
+		for (;;) {
+			for (int n = 0; n < TimeWarpEngine::GVT_INTERVAL; ++n) {
+				receive();
+				if (!processNext(totalTime)) {
+					break;
+				}
+			}
+
+			// GVT: deliver everything, including anti-messages sent by
+			// the rollbacks the deliveries cause
+			for (;;) {
+				shared.barrier.wait();
+				receive();
+				shared.barrier.wait();
+				bool quiet = shared.inFlight == 0;
+				shared.barrier.wait();
+				if (quiet) {
+					break;
+				}
+			}
+			skipCancelled();
+			shared.nextTime[id] = pending.empty() ? INT_MAX : pending.top_key();
+			shared.barrier.wait();
+
+			int gvt = *std::min_element(shared.nextTime.begin(),
+				shared.nextTime.end());
+			if (gvt > totalTime) {
+				commit(processedEnd());
+				traced.flush();
+				break;
+			}
+			fossilCollect(gvt);
+		}
+	}
+
+private:
+	struct Processed {  // Event already run and what it scheduled
+		EventRecord event;
+		EventOutcome outcome;
+		EventRecord scheduled[EventSink::CAPACITY];
+		int scheduledCount;
+		// States saved before it ran, at the back of the logs (see save)
+		int entries, exits, semaphores, lights;
+	};
+
+	// State of one thing an event may change, as it was before the event
+	struct SavedEntry {
+		int roadway;
+		Roadway::EntryState state;
+	};
+	struct SavedExit {
+		int roadway;
+		Roadway::ExitState state;
+	};
+	struct SavedSemaphore {
+		int semaphore;
+		Semaphore::State state;
+	};
+	struct SavedLights {
+		int intersection;
+		LightController::State state;
+	};
+
+	int id;
+	Network& network;
+	const Partitioning& partitioning;
+	Shared& shared;
+	Queue pending;
+	std::multiset<Identity> cancelled;  // Pending events to drop
+	std::deque<Processed> processed;
+	std::uint64_t firstProcessed = 0;  // Index of processed.front()
+	std::uint64_t committed = 0;  // Processed before it can't roll back
+	TraceBuffer traced;  // Committed events
+	// Undo logs, in the order of processed
+	std::deque<SavedEntry> savedEntries;
+	std::deque<SavedExit> savedExits;
+	std::deque<SavedSemaphore> savedSemaphores;
+	std::deque<SavedLights> savedLights;
+	std::vector<Message> received;
+
+	std::uint64_t processedEnd() const {
+		return firstProcessed + processed.size();
+	}
+
+	void skipCancelled() {
+		while (!cancelled.empty() && !pending.empty()) {
+			auto it = cancelled.find(identityOf(pending.top()));
+			if (it == cancelled.end()) {
+				break;
+			}
+			cancelled.erase(it);
+			pending.pop();
+		}
+	}
+
+	bool processNext(int totalTime) {
+		skipCancelled();
+		if (pending.empty() || pending.top_key() > totalTime) {
+			return false;
+		}
+		processed.emplace_back();
+		Processed& p = processed.back();
+		p.event = pending.pop();
+		save(p);
+		EventSink newEvents;
+		p.outcome = dispatch(p.event, network, newEvents);
+		processedCount++;
+
+		p.scheduledCount = newEvents.size();
+		for (auto i = 0; i < newEvents.size(); ++i) {
+			auto& e = newEvents[i];
+			p.scheduled[i] = e;
+			int to = partitioning.owner(e);
+			if (to == id) {
+				pending.push(e.time, tieBreak(e), e);
+			} else {
+				send(to, {e, false});
+			}
+		}
+		peak = std::max(peak, pending.size());
+		return true;
+	}
+
+	void send(int to, const Message& m) {
+		shared.inFlight++;
+		Inbox& inbox = shared.inboxes[to];
+		std::lock_guard<std::mutex> lock(inbox.mutex);
+		inbox.messages.push_back(m);
+	}
+
+	void receive() {
+		Inbox& inbox = shared.inboxes[id];
+		{
+			std::lock_guard<std::mutex> lock(inbox.mutex);
+			received.swap(inbox.messages);
+		}
+		for (auto& m : received) {
+			shared.inFlight--;
+			rollback(keyOf(m.event));
+			if (m.anti) {
+				cancelled.insert(identityOf(m.event));
+			} else {
+				pending.push(m.event.time, tieBreak(m.event), m.event);
+			}
+		}
+		received.clear();
+		peak = std::max(peak, pending.size());
+	}
+
+	/**
+	 * Undoes every processed event from the first one with key or a
+	 * later one, so an event with that key can run (or be cancelled) in
+	 * order. Times never go down along processed, but keys may: a
+	 * wake-up runs at once, before later events of the same time.
+	 */
+	void rollback(const Key& key) {
+		auto end = processedEnd(), first = end;
+		for (auto i = end; i > firstProcessed; --i) {
+			auto& e = processed[i - 1 - firstProcessed].event;
+			if (e.time < key.first) {
+				break;
+			}
+			if (!(keyOf(e) < key)) {
+				first = i - 1;
+			}
+		}
+		if (first == end) {
+			return;
+		}
+		rollbacks++;
+
+		// Undone from the last one, back to the queue, cancelling what
+		// they scheduled
+		for (auto i = end; i > first; --i) {
+			Processed& p = processed.back();
+			undo(p);
+			pending.push(p.event.time, tieBreak(p.event), p.event);
+			for (int k = 0; k < p.scheduledCount; ++k) {
+				auto& e = p.scheduled[k];
+				int to = partitioning.owner(e);
+				if (to == id) {
+					cancelled.insert(identityOf(e));
+				} else {
+					send(to, {e, true});
+				}
+			}
+			processed.pop_back();
+			rolledBack++;
+		}
+	}
+
+	/**
+	 * Saves, before p.event runs, the state of what it may change
+	 * (incremental state saving): the sides of its target roadway, and
+	 * for a vehicle that moves on, the semaphore and the sides of every
+	 * exit it may pick; for a light change, the intersection's lights.
+	 * Central roadways get a vehicle only with the ARRIVE_VEHICLE event
+	 * of their exit side, and give space back only with FREE_SPACE.
+	 */
+	void save(Processed& p) {
+		p.entries = p.exits = p.semaphores = p.lights = 0;
+		auto entry = [&](const Roadway& r) {
+			savedEntries.emplace_back();
+			savedEntries.back().roadway = r.id();
+			r.save(savedEntries.back().state);
+			p.entries++;
+		};
+		auto exit = [&](const Roadway& r) {
+			savedExits.emplace_back();
+			savedExits.back().roadway = r.id();
+			r.save(savedExits.back().state);
+			p.exits++;
+		};
+
+		const EventRecord& e = p.event;
+		switch (e.kind) {
+		case EventKind::SWITCH_PHASE:
+			savedLights.push_back({e.target, network.lights(e.target)});
+			p.lights++;
+			break;
+		case EventKind::CREATE_VEHICLE:
+		case EventKind::REMOVE_VEHICLE:
+			entry(network.roadway(e.target));
+			exit(network.roadway(e.target));
+			break;
+		case EventKind::FREE_SPACE:
+			entry(network.roadway(e.target));
+			break;
+		case EventKind::CHANGE_ROADWAY:
+		case EventKind::ARRIVE_VEHICLE: {
+			const Roadway& r = network.roadway(e.target);
+			exit(r);
+			if (r.kind() != Roadway::CENTRAL) {
+				entry(r);
+			}
+			const Semaphore& semaphore = r.getSemaphore();
+			savedSemaphores.emplace_back();
+			savedSemaphores.back().semaphore = semaphore.id();
+			semaphore.save(savedSemaphores.back().state);
+			p.semaphores++;
+
+			Roadway* exits[3];
+			r.exitsOf(exits);
+			for (int k = 0; k < 3; ++k) {
+				if (exits[k] == nullptr ||
+						std::find(exits, exits + k, exits[k]) != exits + k) {
+					continue;
+				}
+				entry(*exits[k]);
+				if (exits[k]->kind() != Roadway::CENTRAL) {
+					exit(*exits[k]);
+				}
+			}
+			break;
+		}
+		}
+	}
+
+	// Puts back what save(p) saved, and drops it from the logs
+	void undo(const Processed& p) {
+		for (int k = 0; k < p.entries; ++k) {
+			auto& saved = savedEntries.back();
+			network.roadway(saved.roadway).restore(saved.state);
+			savedEntries.pop_back();
+		}
+		for (int k = 0; k < p.exits; ++k) {
+			auto& saved = savedExits.back();
+			network.roadway(saved.roadway).restore(saved.state);
+			savedExits.pop_back();
+		}
+		for (int k = 0; k < p.semaphores; ++k) {
+			auto& saved = savedSemaphores.back();
+			network.semaphore(saved.semaphore).restore(saved.state);
+			savedSemaphores.pop_back();
+		}
+		for (int k = 0; k < p.lights; ++k) {
+			auto& saved = savedLights.back();
+			network.lights(saved.intersection) = saved.state;
+			savedLights.pop_back();
+		}
+	}
+
+	/**
+	 * Events before gvt can't be rolled back any more: commits them and
+	 * drops them, with the states saved for them.
+	 */
+	void fossilCollect(int gvt) {
+		while (!processed.empty() && processed.front().event.time < gvt) {
+			commit(firstProcessed + 1);
+			const Processed& p = processed.front();
+			savedEntries.erase(savedEntries.begin(),
+				savedEntries.begin() + p.entries);
+			savedExits.erase(savedExits.begin(),
+				savedExits.begin() + p.exits);
+			savedSemaphores.erase(savedSemaphores.begin(),
+				savedSemaphores.begin() + p.semaphores);
+			savedLights.erase(savedLights.begin(),
+				savedLights.begin() + p.lights);
+			processed.pop_front();
+			firstProcessed++;
+		}
+	}
+
+	// Processed events before end are final: traces them
+	void commit(std::uint64_t end) {
+		for (; committed < end; ++committed) {
+			auto& p = processed[committed - firstProcessed];
+			traced.add(p.event, p.outcome);
+		}
+	}
+};
+
+}  // namespace
+
+TimeWarpEngine::TimeWarpEngine(Network& network, int partitions) :
+	network(network),
+	partitioning(network, partitions) {}
+
+template<typename Queue>
+void TimeWarpEngine::run(const std::vector<EventRecord>& initialEvents,
+		int totalTime, TraceFile* trace) {
+	int n = partitioning.count();
+	Shared shared(n);
+	std::vector<std::unique_ptr<LogicalProcess<Queue>>> processes(n);
+	for (int p = 0; p < n; ++p) {
+		processes[p].reset(
+			new LogicalProcess<Queue>(p, network, partitioning, shared, trace));
+	}
+	for (auto& e : initialEvents) {
+		processes[partitioning.owner(e)]->schedule(e);
+	}
+
+	std::vector<std::thread> threads;
+	for (int p = 1; p < n; ++p) {
+		threads.emplace_back([&, p] { processes[p]->run(totalTime); });
+	}
+	processes[0]->run(totalTime);
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	peakEvents_ = 0;
+	eventsProcessed_ = eventsRolledBack_ = rollbacks_ = 0;
+	for (auto& process : processes) {
+		peakEvents_ += process->peak;
+		eventsProcessed_ += process->processedCount - process->rolledBack;
+		eventsRolledBack_ += process->rolledBack;
+		rollbacks_ += process->rollbacks;
+	}
+}
+
+template void TimeWarpEngine::run<BinaryHeap<EventRecord>>(
+	const std::vector<EventRecord>& initialEvents, int totalTime,
+	TraceFile* trace);
+template void TimeWarpEngine::run<CalendarQueue<EventRecord>>(
+	const std::vector<EventRecord>& initialEvents, int totalTime,
+	TraceFile* trace);
+
+int TimeWarpEngine::partitions() const {
+	return partitioning.count();
+}
+
+std::size_t TimeWarpEngine::peakEvents() const {
+	return peakEvents_;
+}
+
+std::uint64_t TimeWarpEngine::eventsProcessed() const {
+	return eventsProcessed_;
+}
+
+std::uint64_t TimeWarpEngine::eventsRolledBack() const {
+	return eventsRolledBack_;
+}
+
+std::uint64_t TimeWarpEngine::rollbacks() const {
+	return rollbacks_;
+}
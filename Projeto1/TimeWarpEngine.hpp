@@ -0,0 +1,73 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef TIME_WARP_ENGINE_HPP
+#define TIME_WARP_ENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Event.hpp"
+#include "Network.hpp"
+#include "Partitioning.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Runs one simulation on several threads, optimistically (Time Warp)
+ *
+ * Each partition (see Partitioning) runs its events as soon as it has
+ * them, without waiting for the others. Before running one, it saves the
+ * state of only what that event may change: the sides of the roadways,
+ * the semaphore or the lights it touches (incremental state saving).
+ * When an event from another partition arrives in its past (a
+ * straggler), the partition rolls back: it undoes, from the last one,
+ * the events from the straggler on, puts them back in its queue, and
+ * cancels the events they sent: the local ones are dropped when they
+ * come out of the queue, the remote ones with an anti-message, which may
+ * roll back the receiver in turn.
+ *
+ * Every GVT_INTERVAL events the partitions stop, deliver every message
+ * still on its way and take the smallest pending time: the global
+ * virtual time (GVT). Nothing before it can be rolled back any more, so
+ * older events and their saved states are thrown away (fossil
+ * collection); the run ends when the GVT passes totalTime. Events at the
+ * same time are handled in tieBreak order, so the results are the same
+ * as the sequential run's.
+ */
+class TimeWarpEngine {
+public:
+	static const int GVT_INTERVAL = 4096;  // Events between GVT rounds
+
+private:
+	Network& network;
+	Partitioning partitioning;
+	std::size_t peakEvents_ = 0;
+	std::uint64_t eventsProcessed_ = 0, eventsRolledBack_ = 0;
+	std::uint64_t rollbacks_ = 0;
+
+public:
+	/**
+	 * @throws std::runtime_error if a roadway is fed from two partitions
+	 */
+	TimeWarpEngine(Network& network, int partitions);
+
+	/**
+	 * @brief Runs the events up to (and including) totalTime
+	 *
+	 * @tparam Queue Pending-events queue: BinaryHeap or CalendarQueue
+	 * @param trace Where each partition writes the events it runs, if any
+	 */
+	template<typename Queue>
+	void run(const std::vector<EventRecord>& initialEvents, int totalTime,
+		TraceFile* trace = nullptr);
+
+	int partitions() const;
+
+	std::size_t peakEvents() const;  // Sum of the partitions' peaks
+	std::uint64_t eventsProcessed() const;  // Committed (not undone)
+	std::uint64_t eventsRolledBack() const;  // Run, then undone
+	std::uint64_t rollbacks() const;
+};
+
+#endif  // TIME_WARP_ENGINE_HPP
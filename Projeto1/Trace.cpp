@@ -0,0 +1,100 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#include "Trace.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[8] = {'T', 'J', 'T', 'R', 'A', 'C', 'E', '3'};
+
+struct Header {
+	char magic[8];
+	std::uint32_t recordSize;
+	std::uint32_t unused;
+	std::uint64_t descriptionSize;  // Bytes, then padding up to 8
+};
+
+static_assert(sizeof(TraceRecord) == 12, "trace records are 12 bytes");
+
+}  // namespace
+
+TraceFile::TraceFile(const std::string& path, const std::string& description)
+		: out(path, std::ios::binary | std::ios::trunc), path(path) {
+	Header header = {};
+	std::memcpy(header.magic, MAGIC, sizeof MAGIC);
+	header.recordSize = sizeof(TraceRecord);
+	header.descriptionSize = description.size();
+	const char padding[8] = {};
+	out.write(reinterpret_cast<const char*>(&header), sizeof header);
+	out.write(description.data(), description.size());
+	out.write(padding, (8 - description.size() % 8) % 8);
+	if (!out) {
+		throw std::runtime_error("não foi possível escrever " + path);
+	}
+}
+
+void TraceFile::append(const TraceRecord* records, std::size_t count) {
+	std::lock_guard<std::mutex> lock(mutex);
+	out.write(reinterpret_cast<const char*>(records),
+		count * sizeof(TraceRecord));
+	if (!out) {
+		throw std::runtime_error("não foi possível escrever " + path);
+	}
+}
+
+TraceBuffer::TraceBuffer(TraceFile* file) : file(file) {
+	if (file != nullptr) {
+		records.reserve(CAPACITY);
+	}
+}
+
+TraceBuffer::~TraceBuffer() {
+	// Normally flushed already; on the way out of an exception, keep
+	// what can be kept
+	try {
+		flush();
+	} catch (std::runtime_error&) {}
+}
+
+void TraceBuffer::flush() {
+	if (file != nullptr && !records.empty()) {
+		try {
+			file->append(records.data(), records.size());
+		} catch (std::runtime_error&) {
+			records.clear();  // Not again from the destructor
+			throw;
+		}
+		records.clear();
+	}
+}
+
+TraceReader::TraceReader(const std::string& path) :
+		in(path, std::ios::binary) {
+	if (!in) {
+		throw std::runtime_error("não foi possível abrir " + path);
+	}
+	Header header;
+	in.read(reinterpret_cast<char*>(&header), sizeof header);
+	if (!in || std::memcmp(header.magic, MAGIC, sizeof MAGIC) != 0 ||
+			header.recordSize != sizeof(TraceRecord)) {
+		throw std::runtime_error(path + " não é um trace");
+	}
+	description_.resize(header.descriptionSize);
+	in.read(&description_[0], header.descriptionSize);
+	in.ignore((8 - header.descriptionSize % 8) % 8);
+	if (!in) {
+		throw std::runtime_error(path + " está truncado");
+	}
+}
+
+const std::string& TraceReader::description() const {
+	return description_;
+}
+
+std::size_t TraceReader::read(TraceRecord* records, std::size_t max) {
+	in.read(reinterpret_cast<char*>(records), max * sizeof(TraceRecord));
+	return in.gcount() / sizeof(TraceRecord);
+}
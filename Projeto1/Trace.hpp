@@ -0,0 +1,110 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Event.hpp"
+
+/**
+ * @brief One event that ran, as stored in a trace (12 bytes)
+ */
+struct TraceRecord {
+	std::int32_t time;
+	std::int32_t target;  // Roadway id; intersection id for SWITCH_PHASE
+	EventKind kind;
+	EventOutcome outcome;
+	std::uint8_t size;  // Vehicle size (ARRIVE_VEHICLE, FREE_SPACE)
+	std::uint8_t unused;
+};
+
+/**
+ * @brief Binary file with every event a simulation ran
+ *
+ * A header, the network description (so a trace can be read without
+ * anything else), then TraceRecords, 8-byte aligned. Threads fill their
+ * own TraceBuffer and only lock the file to append a whole buffer, so
+ * the records come in blocks of one thread each, in time order inside a
+ * block but not across them.
+ */
+class TraceFile {
+private:
+	std::mutex mutex;
+	std::ofstream out;
+	std::string path;
+
+public:
+	/**
+	 * @throws std::runtime_error if the file can't be created
+	 */
+	TraceFile(const std::string& path, const std::string& description);
+
+	/**
+	 * @brief Appends records (from any thread)
+	 *
+	 * @throws std::runtime_error if the file can't be written
+	 */
+	void append(const TraceRecord* records, std::size_t count);
+};
+
+/**
+ * @brief Records of one thread, written to a TraceFile when full
+ *
+ * The records live on the heap, and only when tracing, so a loop without
+ * a trace doesn't carry CAPACITY records on its stack.
+ */
+class TraceBuffer {
+public:
+	static const int CAPACITY = 4096;  // Records per write
+
+	explicit TraceBuffer(TraceFile* file);  // nullptr: tracing off
+	~TraceBuffer();
+
+	void add(const EventRecord& e, EventOutcome outcome) {
+		if (file == nullptr) {
+			return;
+		}
+		if (records.size() == std::size_t(CAPACITY)) {
+			flush();
+		}
+		records.push_back({e.time, e.target, e.kind, outcome, e.size, 0});
+	}
+	void flush();
+
+private:
+	TraceFile* file;
+	std::vector<TraceRecord> records;  // Reserved to CAPACITY if tracing
+};
+
+/**
+ * @brief Reads a trace, a block of records at a time
+ */
+class TraceReader {
+private:
+	std::ifstream in;
+	std::string description_;
+
+public:
+	/**
+	 * @throws std::runtime_error if path can't be opened or is not a trace
+	 */
+	explicit TraceReader(const std::string& path);
+
+	const std::string& description() const;  // Of the traced network
+
+	/**
+	 * @brief Reads up to max records into records
+	 *
+	 * @return Records read; 0 at the end of the trace
+	 */
+	std::size_t read(TraceRecord* records, std::size_t max);
+};
+
+#endif  // TRACE_HPP
@@ -3,12 +3,31 @@
 // Leticia do Nascimento
 
 #include "Vehicle.hpp"
-#include <cstdlib>
+Vehicle::Vehicle(double u) {
+	size = SIZE_ + SIZE_VAR * u;
+}
 
-Vehicle::Vehicle() {
-	size = SIZE_ + SIZE_VAR * (double(rand()) / RAND_MAX);
+Vehicle Vehicle::withSize(int size) {
+	Vehicle v(0.0);
+	v.size = size;
+	return v;
 }
 
-int Vehicle::getSize() {
+int Vehicle::getSize() const {
 	return size;
+}
+
+int Vehicle::getArrival() const {
+	return arrival;
+}
+
+void Vehicle::setArrival(int time) {
+	arrival = time;
+}
+int Vehicle::getDestination() const {
+	return destination - 1;
+}
+
+void Vehicle::setDestination(int exit) {
+	destination = exit + 1;
 }
\ No newline at end of file
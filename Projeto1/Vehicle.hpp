@@ -5,17 +5,31 @@
 #ifndef VEHICLE_HPP
 #define VEHICLE_HPP
 
+#include <cstdint>
+
 /**
  * @brief Class that represents a vehicle.
  */
 
 class Vehicle {
 private:
-	int size;  // Vehicle's size
-	const int SIZE_ = 5, SIZE_VAR = 4;  // Fixed and variable sizes
+	int arrival = 0;  // Time it joined the current queue
+	std::uint16_t size = 0;  // Vehicle's size
+	std::uint16_t destination = 0;  // Exit number + 1; 0: turns at random
 public:
-	Vehicle();  // Constructor
-	int getSize();  // Returns the vehicle's size
+	static const int SIZE_ = 5, SIZE_VAR = 4;  // Fixed and variable sizes
+
+	Vehicle() = default;  // Empty slot of a queue
+	explicit Vehicle(double u);  // Constructor; u: uniform in [0, 1)
+	static Vehicle withSize(int size);  // Vehicle whose size is known
+	int getSize() const;  // Returns the vehicle's size
+	int getArrival() const;
+	void setArrival(int time);
+	int getDestination() const;  // Exit number (see Network); -1: none
+	void setDestination(int exit);
 };
 
+// Two per 16 bytes in the roadways' rings
+static_assert(sizeof(Vehicle) == 8, "Vehicle should take 8 bytes");
+
 #endif  // VEHICLE_HPP
\ No newline at end of file
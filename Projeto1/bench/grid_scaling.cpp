@@ -0,0 +1,71 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+// Scaling benchmark: runs generated N x N grids for several simulated
+// times with both schedulers and the time-stepped engine, and reports
+// events per second, peak pending events and peak resident memory (the
+// stepped engine has no events: compare the seconds).
+//
+// Build (from Projeto1/): make build/grid_scaling
+//
+// Usage: grid_scaling [max side (default 32)] [simulated times...]
+
+#include <sys/resource.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Grid.hpp"
+#include "Simulation.hpp"
+
+// Peak resident set size of the process so far, in MiB
+static double peakRssMiB() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;  // ru_maxrss is in KiB on Linux
+}
+
+int main(int argc, char const *argv[]) {
+	int maxSide = argc > 1 ? atoi(argv[1]) : 32;
+	std::vector<int> times;
+	for (int i = 2; i < argc; ++i) {
+		times.push_back(atoi(argv[i]));
+	}
+	if (times.empty()) {
+		times = {3600, 36000};
+	}
+
+	const int SEMAPH_FREQUENCY = 30;
+	const Simulation::Scheduler SCHEDULERS[] = {Simulation::HEAP,
+		Simulation::CALENDAR, Simulation::STEPPED};
+	const char* NAMES[] = {"heap", "calendar", "stepped"};
+
+	printf("%-9s %9s %9s %-8s %12s %9s %12s %10s %9s\n", "grid",
+		"roadways", "time", "queue", "events", "seconds", "events/s",
+		"peak", "rss(MiB)");
+
+	// Smallest grids first: ru_maxrss is a high-water mark of the process
+	for (int side = 1; side <= maxSide; side *= 2) {
+		std::string description = gridNetwork(side, side);
+		for (int totalTime : times) {
+			for (int q = 0; q < 3; ++q) {
+				Simulation simulation(description, SEMAPH_FREQUENCY, Random(1));
+
+				auto start = std::chrono::steady_clock::now();
+				simulation.run(totalTime, SCHEDULERS[q]);
+				std::chrono::duration<double> elapsed =
+					std::chrono::steady_clock::now() - start;
+
+				double seconds = elapsed.count();
+				auto events = simulation.eventsProcessed();
+				printf("%4dx%-4d %9d %9d %-8s %12llu %9.3f %12.0f %10zu %9.1f\n",
+					side, side, simulation.network().roadwayCount(), totalTime,
+					NAMES[q], (unsigned long long) events, seconds,
+					seconds > 0 ? events / seconds : 0.0,
+					simulation.peakEvents(), peakRssMiB());
+			}
+		}
+	}
+	return 0;
+}
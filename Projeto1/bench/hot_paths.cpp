@@ -0,0 +1,234 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+// Microbenchmarks of the event loop's hot paths: the pending-events
+// queues (hold model: pop one, push one later), Roadway::add/pop,
+// moveVehicle, the Vehicle constructor, and whole runs of the built-in
+// two-intersection network. Reports ns per operation and heap
+// allocations per operation (counted by replacing operator new), and
+// events per second for the runs, so regressions show up as numbers.
+//
+// Build (from Projeto1/): make build/hot_paths
+//
+// Usage: hot_paths [scale (default 1): multiplies the iterations]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Network.hpp"
+#include "Simulation.hpp"
+#include "binary_heap.h"
+#include "calendar_queue.h"
+
+static std::uint64_t allocations = 0;  // Calls to operator new so far
+
+void* operator new(std::size_t size) {
+	allocations++;
+	void* p = std::malloc(size > 0 ? size : 1);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+volatile std::uint64_t sink;  // Keeps results from being optimized out
+
+// Time and allocations of a stretch of work, added up over laps
+struct Meter {
+	double seconds = 0;
+	std::uint64_t allocations = 0, operations = 0;
+	Clock::time_point start;
+	std::uint64_t startAllocations = 0;
+
+	void begin() {
+		startAllocations = ::allocations;
+		start = Clock::now();
+	}
+	void end(std::uint64_t count) {
+		std::chrono::duration<double> lap = Clock::now() - start;
+		seconds += lap.count();
+		allocations += ::allocations - startAllocations;
+		operations += count;
+	}
+	void print(const char* name) const {
+		printf("%-40s %12llu %10.1f %10.3f\n", name,
+			(unsigned long long) operations,
+			operations > 0 ? seconds * 1e9 / operations : 0.0,
+			operations > 0 ? double(allocations) / operations : 0.0);
+	}
+};
+
+// Hold model: size pending events, each operation pops the first and
+// pushes one up to 100 s later, as the simulation does
+template<typename Queue>
+void holdModel(const char* name, std::size_t size, std::uint64_t count) {
+	Queue queue;
+	Random random(1);
+	for (std::size_t i = 0; i < size; ++i) {
+		EventRecord e = {int(random.uniform() * 100), int(i), 0,
+			EventKind::CHANGE_ROADWAY, 0, 0};
+		queue.push(e.time, tieBreak(e), e);
+	}
+	Meter meter;
+	std::uint64_t checksum = 0;
+	meter.begin();
+	for (std::uint64_t i = 0; i < count; ++i) {
+		EventRecord e = queue.pop();
+		checksum += e.target;
+		e.time += 1 + int(random.uniform() * 100);
+		queue.push(e.time, tieBreak(e), e);
+	}
+	meter.end(count);
+	sink = checksum;
+	char label[64];
+	snprintf(label, sizeof label, "%s pop+push (%zu pending)", name, size);
+	meter.print(label);
+}
+
+std::unique_ptr<Network> twoIntersections() {
+	// Without planLights every light stays green
+	std::unique_ptr<Network> network(new Network());
+	std::istringstream in(Network::TWO_INTERSECTIONS);
+	network->load(in);
+	network->seed(Random(1));
+	return network;
+}
+
+void roadwayAddPop(std::uint64_t count) {
+	auto network = twoIntersections();
+	Roadway& exit = network->roadway("O1oeste");  // 2000 m
+	const int LAP = 64;
+	Meter add, pop;
+	std::uint64_t checksum = 0;
+	for (std::uint64_t done = 0; done < count; done += LAP) {
+		add.begin();
+		for (int i = 0; i < LAP; ++i) {
+			exit.add(Vehicle::withSize(5 + i % 4), int(done) + i);
+		}
+		add.end(LAP);
+		pop.begin();
+		for (int i = 0; i < LAP; ++i) {
+			checksum += exit.pop(int(done) + i).getSize();
+		}
+		pop.end(LAP);
+	}
+	sink = checksum;
+	add.print("Roadway::add");
+	pop.print("Roadway::pop");
+}
+
+// Vehicles stopped at a source go to its exits; the exits are emptied
+// (and the space taken on a central one given back) between laps
+void moveVehicles(std::uint64_t count) {
+	auto network = twoIntersections();
+	Roadway& source = network->roadway("O1leste");
+	const int LAP = 32;
+	Meter meter;
+	std::vector<std::pair<Roadway*, int>> moved(LAP);
+	int time = 0;
+	for (std::uint64_t done = 0; done < count; done += LAP) {
+		for (int i = 0; i < LAP; ++i) {
+			source.add(Vehicle::withSize(5 + i % 4), time);
+			source.stop();
+		}
+		meter.begin();
+		for (int i = 0; i < LAP; ++i) {
+			int size;
+			moved[i].first = &source.moveVehicle(time, size);
+			moved[i].second = size;
+		}
+		meter.end(LAP);
+		for (auto& m : moved) {
+			if (m.first->kind() == Roadway::CENTRAL) {
+				m.first->release(m.second);
+			} else {
+				m.first->pop(time);
+			}
+		}
+		time++;
+	}
+	meter.print("Roadway::moveVehicle");
+}
+
+void vehicleConstructor(std::uint64_t count) {
+	const int LAP = 1024;
+	std::vector<double> uniforms(LAP);
+	Random random(1);
+	random.fill(uniforms.data(), LAP);
+	Meter meter;
+	std::uint64_t checksum = 0;
+	for (std::uint64_t done = 0; done < count; done += LAP) {
+		meter.begin();
+		for (int i = 0; i < LAP; ++i) {
+			checksum += Vehicle(uniforms[i]).getSize();
+		}
+		meter.end(LAP);
+	}
+	sink = checksum;
+	meter.print("Vehicle(u)");
+}
+
+void fullRuns(int scale) {
+	printf("\n%-9s %6s %-8s %10s %9s %12s %9s %10s\n", "time", "freq",
+		"queue", "events", "seconds", "events/s", "ns/event", "allocs/ev");
+	const Simulation::Scheduler SCHEDULERS[] = {Simulation::HEAP,
+		Simulation::CALENDAR};
+	const char* NAMES[] = {"heap", "calendar"};
+	for (int totalTime : {3600, 36000, 360000}) {
+		for (int frequency : {15, 30, 60}) {
+			for (int q = 0; q < 2; ++q) {
+				Simulation simulation(Network::TWO_INTERSECTIONS, frequency,
+					Random(1));
+				Meter meter;
+				meter.begin();
+				simulation.run(totalTime * scale, SCHEDULERS[q]);
+				meter.end(simulation.eventsProcessed());
+				double perEvent = meter.operations > 0 ?
+					meter.seconds / meter.operations : 0;
+				printf("%-9d %6d %-8s %10llu %9.3f %12.0f %9.1f %10.3f\n",
+					totalTime * scale, frequency, NAMES[q],
+					(unsigned long long) meter.operations, meter.seconds,
+					perEvent > 0 ? 1 / perEvent : 0.0, perEvent * 1e9,
+					meter.operations > 0 ?
+					double(meter.allocations) / meter.operations : 0.0);
+			}
+		}
+	}
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+	int scale = argc > 1 ? atoi(argv[1]) : 1;
+	if (scale < 1) {
+		scale = 1;
+	}
+	const std::uint64_t N = 1000000ULL * scale;
+
+	printf("%-40s %12s %10s %10s\n", "operation", "ops", "ns/op",
+		"allocs/op");
+	for (std::size_t size : {64, 1024, 16384}) {
+		holdModel<BinaryHeap<EventRecord>>("BinaryHeap", size, N);
+		holdModel<CalendarQueue<EventRecord>>("CalendarQueue", size, N);
+	}
+	roadwayAddPop(N);
+	moveVehicles(N);
+	vehicleConstructor(10 * N);
+	fullRuns(scale);
+	return 0;
+}
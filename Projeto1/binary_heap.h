@@ -0,0 +1,206 @@
+// Copyright 2017 <Diogo Junior de Souza>
+
+#ifndef STRUCTURES_BINARY_HEAP_H
+#define STRUCTURES_BINARY_HEAP_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint64_t
+#include <stdexcept>  // C++ exceptions
+
+/**
+ *  Estrutura de dados do tipo Heap Binária (fila de prioridade mínima).
+ *
+ *  Organiza os elementos em uma árvore binária completa armazenada em
+ *  vetor, onde cada elemento possui uma chave inteira (ex.: o tempo de um
+ *  evento). O elemento retirado é sempre o de menor chave; elementos com
+ *  chaves iguais saem pelo menor desempate e, com desempates iguais, na
+ *  ordem em que foram inseridos (FIFO).
+ *
+ *  Inserção e retirada custam O(log n).
+ *
+ * @tparam  T   Tipo de dado do template.
+*/
+template<typename T>
+class BinaryHeap {
+ public:
+ /**
+  * @brief Construtor padrão.
+  *
+  * Cria uma heap vazia com capacidade inicial padrão (DEFAULT_SIZE).
+ */
+    BinaryHeap():
+        contents{new Entry[DEFAULT_SIZE]},
+        size_{0u},
+        max_size_{DEFAULT_SIZE},
+        sequence_{0u}
+    {}
+
+ /**
+  * @brief Destrutor da classe BinaryHeap.
+  *
+  * Deleta o objeto e desaloca memória do vetor de elementos.
+ */
+    ~BinaryHeap() {
+        delete [] contents;
+    }
+
+    BinaryHeap(const BinaryHeap&) = delete;
+    BinaryHeap& operator=(const BinaryHeap&) = delete;
+
+ /**
+  * @brief Limpa os dados da Heap.
+ */
+    void clear() {
+        size_ = 0u;
+        sequence_ = 0u;
+    }
+
+ /**
+  * @brief Insere novo elemento na Heap.
+  *
+  * Coloca o elemento no fim do vetor e o "sobe" até sua posição.
+  * Dobra a capacidade do vetor quando está cheio.
+  *
+  * @param  key     chave (prioridade) do elemento; menor sai primeiro.
+  * @param  data    dado do tipo T a ser inserido.
+ */
+    void push(int key, const T& data) {
+        push(key, 0u, data);
+    }
+
+ /**
+  * @brief Insere novo elemento na Heap com desempate explícito.
+  *
+  * @param  key     chave (prioridade) do elemento; menor sai primeiro.
+  * @param  tie     desempate entre chaves iguais; menor sai primeiro.
+  * @param  data    dado do tipo T a ser inserido.
+ */
+    void push(int key, std::uint64_t tie, const T& data) {
+        if (size_ == max_size_) {
+            grow();
+        }
+        Entry novo{key, tie, sequence_++, data};
+        auto i = size_++;
+        while (i > 0) {
+            auto pai = (i - 1) / 2;
+            if (!less(novo, contents[pai])) {
+                break;
+            }
+            contents[i] = contents[pai];
+            i = pai;
+        }
+        contents[i] = novo;
+    }
+
+ /**
+  * @brief Retira o elemento de menor chave.
+  *
+  * @throws "std::out_of_range" caso a Heap esteja vazia.
+  *
+  * @return Elemento de menor chave (menor desempate, depois o mais antigo).
+ */
+    T pop() {
+        if (empty()) {
+            throw std::out_of_range("Heap vazia");
+        }
+        T requested = contents[0].data;
+        Entry ultimo = contents[--size_];
+        std::size_t i = 0u;
+        for (;;) {
+            auto filho = 2 * i + 1;
+            if (filho >= size_) {
+                break;
+            }
+            if (filho + 1 < size_ && less(contents[filho+1], contents[filho])) {
+                filho++;
+            }
+            if (!less(contents[filho], ultimo)) {
+                break;
+            }
+            contents[i] = contents[filho];
+            i = filho;
+        }
+        contents[i] = ultimo;
+        return requested;
+    }
+
+ /**
+  * Olha o elemento de menor chave, sem retirá-lo.
+  *
+  * @throws "std::out_of_range" caso a Heap esteja vazia.
+  *
+  * @return Elemento de menor chave.
+ */
+    const T& top() const {
+        if (empty()) {
+            throw std::out_of_range("Heap vazia");
+        }
+        return contents[0].data;
+    }
+
+ /**
+  * Olha a chave do elemento de menor chave.
+  *
+  * @throws "std::out_of_range" caso a Heap esteja vazia.
+  *
+  * @return Menor chave presente na Heap.
+ */
+    int top_key() const {
+        if (empty()) {
+            throw std::out_of_range("Heap vazia");
+        }
+        return contents[0].key;
+    }
+
+ /**
+  * Verifica se a Heap está vazia.
+  *
+  * @return True se a Heap estiver vazia, False caso contrário.
+ */
+    bool empty() const {
+        return size_ == 0u;
+    }
+
+ /**
+  * Verifica o tamanho atual da Heap.
+  *
+  * @return Inteiro com o número de elementos da Heap.
+ */
+    std::size_t size() const {
+        return size_;
+    }
+
+ private:
+    struct Entry {  // Elemento: chave, desempate, ordem de chegada e dado
+        int key;
+        std::uint64_t tie;
+        std::uint64_t seq;
+        T data;
+    };
+
+    static bool less(const Entry& a, const Entry& b) {
+        if (a.key != b.key) {
+            return a.key < b.key;
+        }
+        return a.tie < b.tie || (a.tie == b.tie && a.seq < b.seq);
+    }
+
+    void grow() {
+        auto novo = new Entry[2 * max_size_];
+        for (auto i = 0u; i < size_; ++i) {
+            novo[i] = contents[i];
+        }
+        delete [] contents;
+        contents = novo;
+        max_size_ *= 2;
+    }
+
+    Entry* contents;
+    std::size_t size_;
+    std::size_t max_size_;
+    std::uint64_t sequence_;
+
+    static const std::size_t DEFAULT_SIZE = 64u;
+};
+
+#endif
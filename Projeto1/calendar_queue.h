@@ -0,0 +1,410 @@
+// Copyright 2017 <Diogo Junior de Souza>
+
+#ifndef STRUCTURES_CALENDAR_QUEUE_H
+#define STRUCTURES_CALENDAR_QUEUE_H
+
+#include <algorithm>  // std::push_heap, std::pop_heap, std::sort
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint64_t
+#include <stdexcept>  // C++ exceptions
+#include <vector>
+
+/**
+ *  Estrutura de dados do tipo Fila Calendário (calendar queue, R. Brown).
+ *
+ *  Fila de prioridade mínima com a mesma interface da BinaryHeap. As
+ *  chaves (inteiros não negativos, ex.: tempo de um evento) são
+ *  espalhadas em "dias" (baldes) de largura fixa de um "ano" circular.
+ *  Cada balde é uma lista ordenada curta de chaves distintas, e cada
+ *  chave guarda os seus elementos num heap pequeno (desempate, ordem de
+ *  inserção). Muitos eventos no mesmo segundo não alongam as listas:
+ *  inserir num segundo que já existe custa O(log k), com k elementos
+ *  nele, e a lista só é percorrida até a chave.
+ *
+ *  O número de baldes dobra ou cai pela metade conforme a quantidade de
+ *  chaves distintas, e a largura dos baldes é recalculada a partir das
+ *  menores chaves distintas, amostradas nos primeiros baldes do ano.
+ *  Elementos com chaves iguais saem pelo menor desempate e, com
+ *  desempates iguais, na ordem em que foram inseridos (FIFO).
+ *
+ * @tparam  T   Tipo de dado do template.
+*/
+template<typename T>
+class CalendarQueue {
+ public:
+ /**
+  * @brief Construtor padrão.
+  *
+  * Cria uma fila vazia com MIN_BUCKETS baldes de largura 1.
+ */
+    CalendarQueue() {
+        resize(MIN_BUCKETS, 1);
+    }
+
+ /**
+  * @brief Destrutor da classe CalendarQueue.
+  *
+  * Deleta o objeto e desaloca memória dos baldes e das chaves.
+ */
+    ~CalendarQueue() {
+        delete [] buckets;
+        for (auto chunk : chunks_) {
+            delete [] chunk;
+        }
+    }
+
+    CalendarQueue(const CalendarQueue&) = delete;
+    CalendarQueue& operator=(const CalendarQueue&) = delete;
+
+ /**
+  * @brief Limpa os dados da Fila.
+  *
+  * Devolve todas as chaves para a lista de chaves livres.
+ */
+    void clear() {
+        for (auto i = 0u; i < nbuckets; ++i) {
+            while (buckets[i] != nullptr) {
+                release(unlink(i));
+            }
+        }
+        size_ = 0u;
+        days_ = 0u;
+        sequence_ = 0u;
+        resize(MIN_BUCKETS, 1);
+    }
+
+ /**
+  * @brief Insere novo elemento na Fila.
+  *
+  * @throws "std::out_of_range" caso a chave seja negativa.
+  *
+  * @param  key     chave (prioridade) do elemento; menor sai primeiro.
+  * @param  data    dado do tipo T a ser inserido.
+ */
+    void push(int key, const T& data) {
+        push(key, 0u, data);
+    }
+
+ /**
+  * @brief Insere novo elemento na Fila com desempate explícito.
+  *
+  * @throws "std::out_of_range" caso a chave seja negativa.
+  *
+  * @param  key     chave (prioridade) do elemento; menor sai primeiro.
+  * @param  tie     desempate entre chaves iguais; menor sai primeiro.
+  * @param  data    dado do tipo T a ser inserido.
+ */
+    void push(int key, std::uint64_t tie, const T& data) {
+        if (key < 0) {
+            throw std::out_of_range("Chave negativa");
+        }
+        Day* day = find(key);
+        day->entries.push_back({tie, sequence_++, data});
+        std::push_heap(day->entries.begin(), day->entries.end(), after);
+        size_++;
+
+        // Chave anterior ao "dia" atual: o calendário volta até ela
+        if (key < bucketTop - width) {
+            lastBucket = bucketOf(key);
+            bucketTop = top(key);
+        }
+
+        if (days_ > 2 * nbuckets) {
+            resize(2 * nbuckets, sampleWidth());
+        }
+    }
+
+ /**
+  * @brief Retira o elemento de menor chave.
+  *
+  * @throws "std::out_of_range" caso a Fila esteja vazia.
+  *
+  * @return Elemento de menor chave (menor desempate, depois o mais antigo).
+ */
+    T pop() {
+        if (empty()) {
+            throw std::out_of_range("Fila vazia");
+        }
+        auto i = findMin();
+        auto& entries = buckets[i]->entries;
+        std::pop_heap(entries.begin(), entries.end(), after);
+        T requested = entries.back().data;
+        entries.pop_back();
+        size_--;
+
+        if (entries.empty()) {
+            release(unlink(i));
+            if (nbuckets > MIN_BUCKETS && days_ < nbuckets / 2) {
+                resize(nbuckets / 2, sampleWidth());
+            }
+        }
+        return requested;
+    }
+
+ /**
+  * Olha o elemento de menor chave, sem retirá-lo.
+  *
+  * @throws "std::out_of_range" caso a Fila esteja vazia.
+  *
+  * @return Elemento de menor chave.
+ */
+    const T& top() {
+        if (empty()) {
+            throw std::out_of_range("Fila vazia");
+        }
+        return buckets[findMin()]->entries.front().data;
+    }
+
+ /**
+  * Olha a chave do elemento de menor chave.
+  *
+  * @throws "std::out_of_range" caso a Fila esteja vazia.
+  *
+  * @return Menor chave presente na Fila.
+ */
+    int top_key() {
+        if (empty()) {
+            throw std::out_of_range("Fila vazia");
+        }
+        return buckets[findMin()]->key;
+    }
+
+ /**
+  * Verifica se a Fila está vazia.
+  *
+  * @return True se a Fila estiver vazia, False caso contrário.
+ */
+    bool empty() const {
+        return size_ == 0u;
+    }
+
+ /**
+  * Verifica o tamanho atual da Fila.
+  *
+  * @return Inteiro com o número de elementos da Fila.
+ */
+    std::size_t size() const {
+        return size_;
+    }
+
+ /**
+  * Verifica o número atual de baldes do calendário.
+  *
+  * @return Inteiro com o número de baldes.
+ */
+    std::size_t buckets_count() const {
+        return nbuckets;
+    }
+
+ private:
+    struct Entry {  // Elemento: desempates e dado
+        std::uint64_t tie;
+        std::uint64_t seq;
+        T data;
+    };
+
+    struct Day {  // Chave distinta: seus elementos (heap) e a próxima
+        int key;
+        std::vector<Entry> entries;
+        Day* next;
+    };
+
+    // Ordem do heap de uma chave: o menor (desempate, seq) na raiz
+    static bool after(const Entry& a, const Entry& b) {
+        return a.tie > b.tie || (a.tie == b.tie && a.seq > b.seq);
+    }
+
+    std::size_t bucketOf(int key) const {
+        return (static_cast<std::size_t>(key) / width) & (nbuckets - 1);
+    }
+
+    long long top(int key) const {  // Fim do "dia" que contém key
+        return (static_cast<long long>(key) / width + 1) * width;
+    }
+
+ /**
+  * Encontra o balde cuja primeira chave é a menor da fila.
+  *
+  * Percorre o ano a partir do dia atual; se nenhum balde tiver chave
+  * dentro do seu dia, faz uma busca direta pela menor primeira chave.
+ */
+    std::size_t findMin() {
+        auto i = lastBucket;
+        auto limit = bucketTop;
+        for (auto n = 0u; n < nbuckets; ++n) {
+            if (buckets[i] != nullptr && buckets[i]->key < limit) {
+                lastBucket = i;
+                bucketTop = limit;
+                return i;
+            }
+            i = (i + 1) & (nbuckets - 1);
+            limit += width;
+        }
+
+        std::size_t min = nbuckets;
+        for (auto b = 0u; b < nbuckets; ++b) {
+            if (buckets[b] != nullptr && (min == nbuckets ||
+                    buckets[b]->key < buckets[min]->key)) {
+                min = b;
+            }
+        }
+        lastBucket = min;
+        bucketTop = top(buckets[min]->key);
+        return min;
+    }
+
+ /**
+  * Chave key no seu balde; criada, na ordem, se ainda não existir.
+ */
+    Day* find(int key) {
+        Day** atual = &buckets[bucketOf(key)];
+        while (*atual != nullptr && (*atual)->key < key) {
+            atual = &(*atual)->next;
+        }
+        if (*atual != nullptr && (*atual)->key == key) {
+            return *atual;
+        }
+        Day* novo = acquire();
+        novo->key = key;
+        novo->next = *atual;
+        *atual = novo;
+        days_++;
+        return novo;
+    }
+
+    void link(Day* day) {  // Insere ordenado no balde (chave nova)
+        Day** atual = &buckets[bucketOf(day->key)];
+        while (*atual != nullptr && (*atual)->key < day->key) {
+            atual = &(*atual)->next;
+        }
+        day->next = *atual;
+        *atual = day;
+    }
+
+    Day* unlink(std::size_t i) {
+        Day* day = buckets[i];
+        buckets[i] = day->next;
+        days_--;
+        return day;
+    }
+
+    Day* acquire() {
+        if (free_ == nullptr) {
+            auto chunk = new Day[CHUNK_SIZE];
+            chunks_.push_back(chunk);
+            for (auto i = 0u; i < CHUNK_SIZE; ++i) {
+                release(&chunk[i]);
+            }
+        }
+        Day* day = free_;
+        free_ = day->next;
+        return day;
+    }
+
+    void release(Day* day) {  // Mantém a capacidade do vetor, para reuso
+        day->entries.clear();
+        day->next = free_;
+        free_ = day;
+    }
+
+ /**
+  * Estima a largura do dia como três vezes a separação média entre as
+  * menores chaves distintas, ignorando separações muito maiores que a
+  * média (eventos isolados no futuro distante).
+  *
+  * As chaves vêm dos baldes a partir do dia atual, um ano no máximo;
+  * se o ano tiver menos de duas, das primeiras chaves de cada balde.
+  * Custa O(baldes), nunca percorre todos os elementos.
+ */
+    int sampleWidth() const {
+        std::vector<int> keys;
+        keys.reserve(SAMPLE_SIZE);
+        auto i = lastBucket;
+        auto limit = bucketTop;
+        for (auto n = 0u; n < nbuckets && keys.size() < SAMPLE_SIZE; ++n) {
+            for (Day* d = buckets[i]; d != nullptr && d->key < limit &&
+                    keys.size() < SAMPLE_SIZE; d = d->next) {
+                keys.push_back(d->key);
+            }
+            i = (i + 1) & (nbuckets - 1);
+            limit += width;
+        }
+        if (keys.size() < 2) {
+            keys.clear();
+            for (auto b = 0u; b < nbuckets; ++b) {
+                if (buckets[b] != nullptr) {
+                    keys.push_back(buckets[b]->key);
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            if (keys.size() > SAMPLE_SIZE) {
+                keys.resize(SAMPLE_SIZE);
+            }
+        }
+        auto samples = keys.size();
+        if (samples < 2) {
+            return width;
+        }
+
+        double average = double(keys[samples-1] - keys[0]) / (samples - 1);
+        double total = 0;
+        auto count = 0u;
+        for (auto k = 1u; k < samples; ++k) {
+            auto gap = keys[k] - keys[k-1];
+            if (gap <= 2 * average) {
+                total += gap;
+                count++;
+            }
+        }
+        int w = count > 0 ? static_cast<int>(3 * total / count) : 1;
+        return w > 0 ? w : 1;
+    }
+
+    void resize(std::size_t count, int newWidth) {
+        Day* all = nullptr;
+        if (buckets != nullptr) {
+            for (auto b = 0u; b < nbuckets; ++b) {
+                while (buckets[b] != nullptr) {
+                    Day* day = buckets[b];
+                    buckets[b] = day->next;
+                    day->next = all;
+                    all = day;
+                }
+            }
+            delete [] buckets;
+        }
+
+        nbuckets = count;
+        width = newWidth;
+        buckets = new Day*[nbuckets]();
+
+        int min = -1;
+        while (all != nullptr) {
+            Day* day = all;
+            all = all->next;
+            if (min < 0 || day->key < min) {
+                min = day->key;
+            }
+            link(day);
+        }
+        lastBucket = min < 0 ? 0u : bucketOf(min);
+        bucketTop = min < 0 ? width : top(min);
+    }
+
+    Day** buckets{nullptr};
+    std::size_t nbuckets{0u};
+    int width{1};  // Largura de cada dia
+    std::size_t lastBucket{0u};  // Dia atual
+    long long bucketTop{1};  // Fim do dia atual
+    std::size_t size_{0u};  // Elementos
+    std::size_t days_{0u};  // Chaves distintas
+    std::uint64_t sequence_{0u};
+    Day* free_{nullptr};  // Chaves livres para reuso
+    std::vector<Day*> chunks_;
+
+    static const std::size_t MIN_BUCKETS = 16u;
+    static const std::size_t CHUNK_SIZE = 256u;
+    static const std::size_t SAMPLE_SIZE = 25u;
+};
+
+#endif
@@ -0,0 +1,172 @@
+// Copyright 2017 <Diogo Junior de Souza>
+
+#ifndef STRUCTURES_RING_QUEUE_H
+#define STRUCTURES_RING_QUEUE_H
+
+#include <cstddef>  // std::size_t
+#include <stdexcept>  // C++ exceptions
+#include <vector>
+
+/**
+ *  Estrutura de dados do tipo Fila circular (ring buffer).
+ *
+ *  Mesma interface da LinkedQueue, mas os elementos ficam lado a lado
+ *  num vetor cujo tamanho é potência de 2: inserir e retirar só avançam
+ *  um índice, sem alocar um nó por elemento. Quando o vetor enche, seu
+ *  tamanho dobra.
+ *
+ * @tparam  T   Tipo de dado do template.
+*/
+template<typename T>
+class RingQueue {
+ public:
+ /**
+  * @brief Construtor padrão.
+  *
+  * Cria uma fila vazia com espaço para pelo menos capacity elementos.
+  *
+  * @param  capacity    elementos que cabem antes de o vetor crescer.
+ */
+    explicit RingQueue(std::size_t capacity = DEFAULT_SIZE) {
+        std::size_t n = 1;
+        while (n < capacity) {
+            n *= 2;
+        }
+        contents.resize(n);
+    }
+
+ /**
+  * @brief Limpa os dados da Fila.
+  *
+  * Mantém o vetor, para ser usado de novo.
+ */
+    void clear() {
+        head = 0;
+        size_ = 0;
+    }
+
+ /**
+  * @brief Insere novo elemento no final da Fila.
+  *
+  * @param  data    dado do tipo T a ser inserido.
+ */
+    void enqueue(const T& data) {
+        if (size_ == contents.size()) {
+            grow();
+        }
+        contents[(head + size_) & (contents.size() - 1)] = data;
+        size_++;
+    }
+
+ /**
+  * @brief Retira o primeiro elemento da Fila.
+  *
+  * @throws "std::out_of_range" caso a Fila esteja vazia.
+  *
+  * @return Elemento que estava na primeira posição da Fila.
+ */
+    T dequeue() {
+        if (empty()) {
+            throw std::out_of_range("Fila vazia");
+        }
+        T data = contents[head];
+        head = (head + 1) & (contents.size() - 1);
+        size_--;
+        return data;
+    }
+
+ /**
+  * Olha o primeiro elemento da fila, sem retirá-lo.
+  *
+  * @throws "std::out_of_range" caso a fila esteja vazia.
+  *
+  * @return Elemento que está no início da fila.
+ */
+    T& front() {
+        if (empty()) {
+            throw std::out_of_range("Fila vazia");
+        }
+        return contents[head];
+    }
+
+    const T& front() const {
+        return const_cast<RingQueue*>(this)->front();
+    }
+
+ /**
+  * Olha o elemento no final da fila, sem retirá-lo.
+  *
+  * @throws "std::out_of_range" caso a fila esteja vazia.
+  *
+  * @return Elemento que está no final da fila.
+ */
+    T& back() {
+        if (empty()) {
+            throw std::out_of_range("Fila vazia");
+        }
+        return contents[(head + size_ - 1) & (contents.size() - 1)];
+    }
+
+    const T& back() const {
+        return const_cast<RingQueue*>(this)->back();
+    }
+
+ /**
+  * Verifica se a Fila está vazia.
+  *
+  * @return True se a Fila estiver vazia, False caso contrário.
+ */
+    bool empty() const {
+        return size_ == 0;
+    }
+
+ /**
+  * Verifica o tamanho atual da Fila.
+  *
+  * @return Inteiro com o número de elementos da Fila.
+ */
+    std::size_t size() const {
+        return size_;
+    }
+
+ /**
+  * Verifica quantos elementos cabem antes de o vetor crescer.
+  *
+  * @return Tamanho do vetor.
+ */
+    std::size_t capacity() const {
+        return contents.size();
+    }
+
+ /**
+  * Aplica uma função a cada elemento da Fila, do primeiro ao último.
+  *
+  * @param  f   função que recebe um elemento (const T&).
+ */
+    template<typename F>
+    void for_each(F f) const {
+        for (std::size_t i = 0; i < size_; ++i) {
+            f(contents[(head + i) & (contents.size() - 1)]);
+        }
+    }
+
+ private:
+ /**
+  * Dobra o tamanho do vetor, deixando o primeiro elemento na posição 0.
+ */
+    void grow() {
+        std::vector<T> novo(2 * contents.size());
+        for (std::size_t i = 0; i < size_; ++i) {
+            novo[i] = contents[(head + i) & (contents.size() - 1)];
+        }
+        contents.swap(novo);
+        head = 0;
+    }
+
+    static const auto DEFAULT_SIZE = 8u;
+    std::vector<T> contents;  // Tamanho potência de 2
+    std::size_t head = 0;  // Posição do primeiro elemento
+    std::size_t size_ = 0;
+};
+
+#endif
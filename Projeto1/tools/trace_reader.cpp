@@ -0,0 +1,172 @@
+// Copyright 2017
+// Diogo Junior de Souza
+// Leticia do Nascimento
+
+// Reads a trace written with --trace=FILE (see Trace.hpp). Without
+// options, sums up the trace: events by kind and outcome, and for each
+// intersection the vehicles that crossed it, per hour, and how often
+// they found the light red or the next roadway full. With --roadway,
+// lists the events of that roadway in time order instead.
+//
+// Build (from Projeto1/): make build/trace_reader
+//
+// Usage: trace_reader TRACE [--roadway=NAME]
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Network.hpp"
+#include "Trace.hpp"
+
+static const char* const KINDS[] = {"switch", "create", "remove", "change",
+	"arrive", "free"};
+static const char* const OUTCOMES[] = {"done", "full", "red", "behind"};
+static const int KIND_COUNT = 6, OUTCOME_COUNT = 4;
+
+// Vehicles that tried to cross each intersection, and how it went
+struct Crossings {
+	long long outcomes[OUTCOME_COUNT] = {};
+};
+
+static void summarize(TraceReader& trace, const Network& network) {
+	// Intersection of each roadway's semaphore
+	std::vector<int> intersectionOf(network.roadwayCount());
+	std::vector<int> bySemaphore(network.semaphoreCount(), -1);
+	for (int i = 0; i < network.intersectionCount(); ++i) {
+		auto& intersection = network.intersection(i);
+		for (int k = 0; k < intersection.semaphoreCount; ++k) {
+			bySemaphore[intersection.firstSemaphore + k] = i;
+		}
+	}
+	for (int id = 0; id < network.roadwayCount(); ++id) {
+		int semaphore = network.roadway(id).getSemaphore().id();
+		intersectionOf[id] = bySemaphore[semaphore];
+	}
+
+	long long counts[KIND_COUNT][OUTCOME_COUNT] = {};
+	std::vector<Crossings> crossings(network.intersectionCount());
+	long long total = 0;
+	int first = 0, last = 0;
+	std::vector<TraceRecord> block(TraceBuffer::CAPACITY);
+	while (std::size_t n = trace.read(block.data(), block.size())) {
+		for (std::size_t i = 0; i < n; ++i) {
+			auto& r = block[i];
+			int kind = static_cast<int>(r.kind);
+			int outcome = static_cast<int>(r.outcome);
+			if (kind >= KIND_COUNT || outcome >= OUTCOME_COUNT) {
+				throw std::runtime_error("registro inválido no trace");
+			}
+			first = total == 0 ? r.time : std::min(first, r.time);
+			last = total == 0 ? r.time : std::max(last, r.time);
+			total++;
+			counts[kind][outcome]++;
+
+			// A vehicle at a light: CHANGE_ROADWAY, or ARRIVE_VEHICLE,
+			// which tries to change right away
+			bool atLight = r.kind == EventKind::CHANGE_ROADWAY ||
+				r.kind == EventKind::ARRIVE_VEHICLE;
+			if (atLight && r.target >= 0 && r.target < network.roadwayCount() &&
+					intersectionOf[r.target] >= 0) {
+				crossings[intersectionOf[r.target]].outcomes[outcome]++;
+			}
+		}
+	}
+
+	printf("%lld eventos, de %d a %d s\n\n", total, first, last);
+	printf("%-8s", "evento");
+	for (auto name : OUTCOMES) {
+		printf(" %12s", name);
+	}
+	printf("\n");
+	for (int k = 0; k < KIND_COUNT; ++k) {
+		printf("%-8s", KINDS[k]);
+		for (int o = 0; o < OUTCOME_COUNT; ++o) {
+			printf(" %12lld", counts[k][o]);
+		}
+		printf("\n");
+	}
+
+	double hours = (last - first) / 3600.0;
+	printf("\n%-16s %10s %10s %10s %10s\n", "cruzamento", "cruzaram",
+		"por hora", "vermelho", "cheia");
+	for (int i = 0; i < network.intersectionCount(); ++i) {
+		auto& c = crossings[i];
+		long long crossed = c.outcomes[static_cast<int>(EventOutcome::DONE)];
+		printf("%-16s %10lld %10.1f %10lld %10lld\n",
+			network.intersection(i).name.c_str(), crossed,
+			hours > 0 ? crossed / hours : 0.0,
+			c.outcomes[static_cast<int>(EventOutcome::RED_LIGHT)],
+			c.outcomes[static_cast<int>(EventOutcome::FULL)]);
+	}
+}
+
+static void list(TraceReader& trace, const Network& network,
+		const std::string& name) {
+	int id = network.roadway(name).id();
+	std::vector<TraceRecord> events;
+	std::vector<TraceRecord> block(TraceBuffer::CAPACITY);
+	while (std::size_t n = trace.read(block.data(), block.size())) {
+		for (std::size_t i = 0; i < n; ++i) {
+			auto& r = block[i];
+			if (static_cast<int>(r.kind) >= KIND_COUNT ||
+					static_cast<int>(r.outcome) >= OUTCOME_COUNT) {
+				throw std::runtime_error("registro inválido no trace");
+			}
+			if (r.target == id && r.kind != EventKind::SWITCH_PHASE) {
+				events.push_back(r);
+			}
+		}
+	}
+	// Blocks of different threads come in any order
+	std::stable_sort(events.begin(), events.end(),
+		[](const TraceRecord& a, const TraceRecord& b) {
+			return a.time < b.time;
+		});
+
+	printf("%10s %-8s %-8s %s\n", "tempo", "evento", "resultado", "tamanho");
+	for (auto& r : events) {
+		printf("%10d %-8s %-8s", r.time, KINDS[static_cast<int>(r.kind)],
+			OUTCOMES[static_cast<int>(r.outcome)]);
+		if (r.kind == EventKind::ARRIVE_VEHICLE ||
+				r.kind == EventKind::FREE_SPACE) {
+			printf(" %d", r.size);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char const *argv[]) {
+	if (argc < 2) {
+		printf("Uso: trace_reader TRACE [--roadway=NOME]\n");
+		return 1;
+	}
+	std::string roadway;
+	for (int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg.compare(0, 10, "--roadway=") == 0) {
+			roadway = arg.substr(10);
+		} else {
+			printf("Argumento inválido: %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	try {
+		TraceReader trace(argv[1]);
+		Network network;
+		std::istringstream in(trace.description());
+		network.load(in);
+		if (roadway.empty()) {
+			summarize(trace, network);
+		} else {
+			list(trace, network, roadway);
+		}
+	} catch (std::exception& err) {
+		printf("%s\n", err.what());
+		return 1;
+	}
+	return 0;
+}
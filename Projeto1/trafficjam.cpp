@@ -2,23 +2,27 @@
 // Diogo Junior de Souza
 // Leticia do Nascimento
 
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
-#include "Event.hpp"
-#include "Roadway.hpp"
-#include "Semaphore.hpp"
-#include "Vehicle.hpp"
-#include "doubly_linked_list.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "Grid.hpp"
+#include "ParallelEngine.hpp"
+#include "Replications.hpp"
+#include "Simulation.hpp"
+#include "Statistics.hpp"
+#include "Sweep.hpp"
 
 // Global variables
 int totalTime, semaphFrequency;
 
-DoublyLinkedList<Event*> events;
-
 int main(int argc, char const *argv[]) {
-	srand(time(0));
-
 	// Initialize totalTime and semaphFrequency
-	if (argc != 3) {
+	if (argc < 3) {
 		std::string totalTime_;
 		std::string semaphFrequency_;
 		std::cout << "Digite o Tempo Total de Simulação: ";
@@ -32,182 +36,305 @@ int main(int argc, char const *argv[]) {
 		semaphFrequency = atoi(argv[2]);
 	}
 
+	// Optional arguments:
+	//   heap | calendar      scheduler backend (default: heap)
+	//   stepped              no events: steps of one second over all
+	//                        roadways, for saturated networks
+	//   --replications=N     run N independent replications
+	//   --threads=N          worker threads for replications (default: all cores)
+	//   --seed=N             master seed (default: current time)
+	//   --network=FILE       network description (default: two intersections)
+	//   --grid=RxC           generated grid of R x C intersections
+	//   --partitions=N       run one simulation on N threads, split by
+	//                        intersection (same results as 1)
+	//   --optimistic         partitions don't wait for each other and
+	//                        roll back when needed (Time Warp)
+	//   --stats=FILE         per-roadway statistics, as JSON if FILE ends
+	//                        in .json, CSV otherwise
+	//   --checkpoint=FILE    saves the whole state to FILE every hour of
+	//                        simulated time, and at the end (heap or
+	//                        calendar, one partition)
+	//   --checkpoint-every=N seconds of simulated time between checkpoints
+	//   --resume=FILE        goes on from a checkpoint of the same network
+	//                        and frequency, up to the total time
+	//   --trace=FILE         every event that runs, in binary (read it
+	//                        with tools/trace_reader)
+	//   --metrics=FILE       live snapshot of the run (time, events per
+	//                        second, pending events, vehicles on each
+	//                        roadway), rewritten about every second
+	//                        (heap or calendar, one partition)
+	//   --metrics-every=N    seconds of simulated time between snapshots
+	//                        (default 60)
+	//   --control=POLICY     lights of the intersections without a control
+	//                        line: fixed, actuated or max-pressure (see
+	//                        LightController)
+	//   --routes             vehicles get a destination, any exit their
+	//                        source reaches, and take the fastest route
+	//                        there (as a "demand * * 1" line)
+	//   --sweep=MIN:MAX[:STEP] searches the cycle lengths (s) that get the
+	//                        most vehicles out (see Sweep): the same cycle
+	//                        everywhere, from MIN to MAX by STEP (default
+	//                        10); --replications is then the number of the
+	//                        first round (default 4)
+	//   --sweep-random=N     also N candidates with a cycle drawn for each
+	//                        intersection
+	//   --steady=WIDTH[:BATCH] stops once throughput and occupancy are in
+	//                        steady state and known within WIDTH of their
+	//                        means (e.g. 0.05), observed every BATCH
+	//                        seconds (default 60); the warm-up is left
+	//                        out of the statistics and the total time is
+	//                        only a limit (see SteadyState)
+	auto scheduler = Simulation::HEAP;
+	auto synchronization = Simulation::CONSERVATIVE;
+	int replications = 0, threads = 0, partitions = 1;
+	int sweepMin = 0, sweepMax = 0, sweepStep = 10, sweepRandom = 0;
+	double steadyWidth = 0;
+	int steadyBatch = 60;
+	std::uint64_t seed = time(0);
+	std::string description = Network::TWO_INTERSECTIONS;
+	std::string statsFile, checkpointFile, resumeFile, traceFile, control;
+	std::string metricsFile;
+	int metricsEvery = 60;
+	bool routes = false;
+	int checkpointEvery = 3600;
+	for (int i = 3; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "calendar") {
+			scheduler = Simulation::CALENDAR;
+		} else if (arg == "heap") {
+			scheduler = Simulation::HEAP;
+		} else if (arg == "stepped") {
+			scheduler = Simulation::STEPPED;
+		} else if (arg.compare(0, 15, "--replications=") == 0) {
+			replications = atoi(arg.c_str() + 15);
+		} else if (arg.compare(0, 10, "--threads=") == 0) {
+			threads = atoi(arg.c_str() + 10);
+		} else if (arg == "--optimistic") {
+			synchronization = Simulation::OPTIMISTIC;
+		} else if (arg.compare(0, 13, "--partitions=") == 0) {
+			partitions = atoi(arg.c_str() + 13);
+		} else if (arg.compare(0, 8, "--stats=") == 0) {
+			statsFile = arg.substr(8);
+		} else if (arg.compare(0, 13, "--checkpoint=") == 0) {
+			checkpointFile = arg.substr(13);
+		} else if (arg.compare(0, 19, "--checkpoint-every=") == 0) {
+			checkpointEvery = atoi(arg.c_str() + 19);
+		} else if (arg.compare(0, 9, "--resume=") == 0) {
+			resumeFile = arg.substr(9);
+		} else if (arg.compare(0, 8, "--trace=") == 0) {
+			traceFile = arg.substr(8);
+		} else if (arg.compare(0, 10, "--metrics=") == 0) {
+			metricsFile = arg.substr(10);
+		} else if (arg.compare(0, 16, "--metrics-every=") == 0) {
+			metricsEvery = atoi(arg.c_str() + 16);
+		} else if (arg.compare(0, 8, "--sweep=") == 0) {
+			int fields = sscanf(arg.c_str() + 8, "%d:%d:%d", &sweepMin,
+				&sweepMax, &sweepStep);
+			if (fields < 2 || sweepMin < 1 || sweepMax < sweepMin ||
+					sweepStep < 1) {
+				std::cout << "Varredura inválida: " << arg << "\n";
+				exit(1);
+			}
+		} else if (arg.compare(0, 15, "--sweep-random=") == 0) {
+			sweepRandom = atoi(arg.c_str() + 15);
+		} else if (arg.compare(0, 9, "--steady=") == 0) {
+			if (sscanf(arg.c_str() + 9, "%lf:%d", &steadyWidth,
+					&steadyBatch) < 1 || !(steadyWidth > 0) ||
+					steadyBatch < 1) {
+				std::cout << "Regime permanente inválido: " << arg << "\n";
+				exit(1);
+			}
+		} else if (arg == "--routes") {
+			routes = true;
+		} else if (arg.compare(0, 10, "--control=") == 0) {
+			control = arg.substr(10);
+			if (control != "fixed" && control != "actuated" &&
+					control != "max-pressure") {
+				std::cout << "Controle inválido: " << control << "\n";
+				exit(1);
+			}
+		} else if (arg.compare(0, 7, "--seed=") == 0) {
+			seed = std::stoull(arg.substr(7));
+		} else if (arg.compare(0, 10, "--network=") == 0) {
+			std::ifstream file(arg.substr(10));
+			if (!file) {
+				std::cout << "Não foi possível abrir " << arg.substr(10) << "\n";
+				exit(1);
+			}
+			std::ostringstream text;
+			text << file.rdbuf();
+			description = text.str();
+		} else if (arg.compare(0, 7, "--grid=") == 0) {
+			int rows = 0, cols = 0;
+			if (sscanf(arg.c_str() + 7, "%dx%d", &rows, &cols) != 2 ||
+					rows < 1 || cols < 1) {
+				std::cout << "Grade inválida: " << arg << "\n";
+				exit(1);
+			}
+			description = gridNetwork(rows, cols);
+		} else {
+			std::cout << "Argumento inválido: " << arg << "\n";
+			exit(1);
+		}
+	}
+
+	if (!control.empty()) {
+		// Last, so it wins over a "control *" line of the file
+		description += "\ncontrol * " + control + "\n";
+	}
+	if (routes) {
+		description += "\ndemand * * 1\n";
+	}
+
 	if (totalTime < 1 || semaphFrequency < 1) {
 		std::cout << "Tempo total ou Frequencia do semáforo inválidos.\n";
 		exit(1);
 	}
+	if (scheduler == Simulation::STEPPED && partitions > 1) {
+		std::cout << "O modo em passos não usa partições.\n";
+		exit(1);
+	}
 
-	// Create and set Semaphores
-	Semaphore* S1w = new Semaphore(true);
-	Semaphore* S1s = new Semaphore();
-	Semaphore* S1e = new Semaphore();
-	Semaphore* S1n = new Semaphore();
-	Semaphore* S2w = new Semaphore(true);
-	Semaphore* S2s = new Semaphore();
-	Semaphore* S2e = new Semaphore();
-	Semaphore* S2n = new Semaphore();
-
-	S1w->setNext(S1s);
-	S1s->setNext(S1e);
-	S1e->setNext(S1n);
-	S1n->setNext(S1w);
-
-	S2w->setNext(S2s);
-	S2s->setNext(S2e);
-	S2e->setNext(S2n);
-	S2n->setNext(S2w);
-
-	// Create and set Roadways
-	// Exit Roadways
-	ExitRoadway W1west(*S1e, 2000, 80);
-	ExitRoadway N1north(*S1s, 500, 60);
-	ExitRoadway S1south(*S1n, 500, 60);
-	ExitRoadway E2east(*S2w, 400, 30);
-	ExitRoadway N2north(*S2s, 500, 40);
-	ExitRoadway S2south(*S1n, 500, 40);
-
-	// Central Roadways
-	CentralRoadway C1west(*S1e, 300, 60, N1north, W1west, S1south, 0.3, 0.7);
-	CentralRoadway C1east(*S2w, 300, 60, S2south, E2east, N2north, 0.3, 0.7);
-
-	// Source Roadways
-	Source W1east(*S1w, 2000, 80, 10, 2, S1south, C1east, N1north, 0.1, 0.9);
-	Source N1south(*S1n, 500, 60, 20, 5, W1west, S1south, C1east, 0.1, 0.9);
-	Source S1north(*S1s, 500, 60, 30, 7, C1east, N1north, W1west, 0.1, 0.9);
-	Source E2west(*S2e, 400, 30, 10, 2, N2north, C1west, S2south, 0.3, 0.7);
-	Source N2south(*S2n, 500, 40, 20, 5, C1west, S2south, E2east, 0.3, 0.7);
-	Source S2north(*S2s, 500, 40, 60, 15, E2east, N2north, C1west, 0.3, 0.7);
-	// Initial events
-	
-	events.insert_sorted( new CreateVehicleEv(0, W1east) );
-	events.insert_sorted( new CreateVehicleEv(0, N1south) );
-	events.insert_sorted( new CreateVehicleEv(0, S1north) );
-	events.insert_sorted( new CreateVehicleEv(0, E2west) );
-	events.insert_sorted( new CreateVehicleEv(0, N2south) );
-	events.insert_sorted( new CreateVehicleEv(0, S2north) );
+	if ((!checkpointFile.empty() || !resumeFile.empty()) &&
+			(replications > 0 || scheduler == Simulation::STEPPED)) {
+		std::cout << "Checkpoints só valem para uma simulação por eventos.\n";
+		exit(1);
+	}
+	if (!traceFile.empty() &&
+			(replications > 0 || scheduler == Simulation::STEPPED)) {
+		std::cout << "O trace só vale para uma simulação por eventos.\n";
+		exit(1);
+	}
+	if (steadyWidth > 0 && (replications > 0 || sweepMin > 0 ||
+			partitions > 1 || scheduler == Simulation::STEPPED ||
+			!checkpointFile.empty() || !resumeFile.empty())) {
+		std::cout << "O regime permanente só vale para uma simulação por "
+			"eventos, em uma partição, sem checkpoints.\n";
+		exit(1);
+	}
+	if (!metricsFile.empty() && (replications > 0 || sweepMin > 0 ||
+			partitions > 1 || scheduler == Simulation::STEPPED ||
+			metricsEvery < 1)) {
+		std::cout << "As métricas só valem para uma simulação por eventos, "
+			"em uma partição, com intervalo positivo.\n";
+		exit(1);
+	}
+	if (!checkpointFile.empty() && (partitions > 1 || checkpointEvery < 1)) {
+		std::cout << "Checkpoints precisam de uma partição e de um "
+			"intervalo positivo.\n";
+		exit(1);
+	}
 
-	events.insert_sorted( new OpenSemaphoreEv(semaphFrequency, *S1w, semaphFrequency) );
-	events.insert_sorted( new OpenSemaphoreEv(semaphFrequency, *S2w, semaphFrequency) );
-	
-	// Main loop of events
-	int currentTime = 0;
-	while ( (currentTime <= totalTime) && !(events.empty()) ) {
-		auto currentEvent = events.pop_front();
+	// Check the network description before starting
+	try {
+		Network network;
+		std::istringstream in(description);
+		network.load(in);
+		network.planLights(semaphFrequency);
+		network.planRoutes();
+		if (scheduler == Simulation::STEPPED && network.adaptive()) {
+			throw std::runtime_error("o modo em passos só tem semáforos de "
+				"tempo fixo");
+		}
+		if (scheduler == Simulation::STEPPED && network.routed()) {
+			throw std::runtime_error("o modo em passos não tem destinos");
+		}
+		if (partitions > 1) {
+			ParallelEngine check(network, partitions);
+		}
+	} catch (std::runtime_error& err) {
+		std::cout << "Rede inválida: " << err.what() << "\n";
+		exit(1);
+	}
 
-		currentTime = currentEvent->getTime();
-		//currentEvent->print();
-		//printf("currentTime: %d\n", currentTime);
+	if (sweepMin > 0) {
+		if (partitions > 1 || !checkpointFile.empty() || !resumeFile.empty() ||
+				!traceFile.empty()) {
+			std::cout << "A varredura roda simulações inteiras, sem "
+				"partições, checkpoints ou trace.\n";
+			exit(1);
+		}
+		Sweep sweep(description, semaphFrequency, threads, seed);
+		sweep.grid(sweepMin, sweepMax, sweepStep);
+		sweep.random(sweepRandom, sweepMin, sweepMax, sweepStep);
+		sweep.run(totalTime, replications > 0 ? replications : 4, scheduler);
+		sweep.print(std::cout);
+		std::cout << "Fim do programa.\n";
+		return 0;
+	}
 
-		auto newEvents = currentEvent->run();
-		unsigned int size = newEvents.size();
-		//printf("newEvents size: %d\n", size);
+	if (replications > 0) {
+		Replications runs(replications, threads, seed, description);
+		runs.run(totalTime, semaphFrequency, scheduler);
+		runs.print(std::cout);
+		std::cout << "Fim do programa.\n";
+		return 0;
+	}
 
-		for (auto i = 0u; i < size; ++i) {
-			events.insert_sorted( newEvents.at(i) );
+	Simulation simulation(description, semaphFrequency, Random(seed));
+	try {
+		if (!traceFile.empty()) {
+			simulation.traceTo(traceFile);
+		}
+		if (!resumeFile.empty()) {
+			int time = simulation.resume(resumeFile);
+			std::cout << "Continuando do instante " << time << "\n";
+		}
+		if (!checkpointFile.empty()) {
+			simulation.checkpointEvery(checkpointEvery, checkpointFile);
 		}
-		//printf("Lista de eventos atual:\n");
-		//events.printAll();		
+		if (!metricsFile.empty()) {
+			simulation.metricsEvery(metricsEvery, metricsFile);
+		}
+		if (steadyWidth > 0) {
+			simulation.stopWhenSteady(steadyBatch, steadyWidth);
+		}
+		simulation.run(totalTime, scheduler, partitions, synchronization);
+	} catch (std::runtime_error& err) {
+		std::cout << "Erro: " << err.what() << "\n";
+		exit(1);
 	}
-	//printf("Saiu do loop.\n");
+	const Network& network = simulation.network();
 
 	// Print output
 	std::cout << "--------------------\n"
 	<< "   RELATÓRIO FINAL\n"
-	<< "Entraram: " << Roadway::totalIn()
-	<< "\nSaíram: " << Roadway::totalOut()
-	<< "\nPermanecem dentro: " << (Roadway::totalIn() - Roadway::totalOut())
-	<< "\n--------------------\n" << std::endl;
- 
-	// Delete all objects
-	delete S1w;
-	delete S1s;
-	delete S1e;
-	delete S1n;
-	delete S2w;
-	delete S2s;
-	delete S2e;
-	delete S2n;
-
-{	/*std::cout << "Relatório:\n" <<
-
-	"\nFontes do Semáforo 1\n" <<
-
-	"N1sul { Entraram: "   << N1south.entered() <<
-	" Sairam: " 		   << N1south.left() <<
-	" Estão dentro: " 	   << N1south.areIn() << " }\n"
-
-	"O1leste { Entraram: " << W1east.entered() <<
-	" Sairam: " 		   << W1east.left() <<
-	" Estão dentro: " 	   << W1east.areIn() << " }\n"
-
-	"S1n { Entraram: " 	   << S1north.entered() <<
-	" Sairam: " 		   << S1north.left() <<
-	" Estão dentro: " 	   << S1north.areIn() << " }\n"
-
-
-	"\nFontes do Semáforo 2\n" <<
-
-	"N2sul { Entraram: "   << N2south.entered() <<
-	" Sairam: " 		   << N2south.left() <<
-	" Estão dentro: " 	   << N2south.areIn() << " }\n"
-
-	"L1oeste { Entraram: " << E2west.entered() <<
-	" Sairam: " 		   << E2west.left() <<
-	" Estão dentro: " 	   << E2west.areIn() << " }\n"
-
-	"S2norte { Entraram: " << S2north.entered() <<
-	" Sairam: " 		   << S2north.left() <<
-	" Estão dentro: " 	   << S2north.areIn() << " }\n"
-
-
-	"\nPistas centrais\n"  <<
-
-	"C1oeste { Entraram: " << C1west.entered() <<
-	" Sairam: " 		   << C1west.left() <<
-	" Estão dentro: " 	   << C1west.areIn() << " }\n"
-
-	"C1leste { Entraram: " << C1east.entered() <<
-	" Sairam: " 		   << C1east.left() <<
-	" Estão dentro: " 	   << C1east.areIn() << " }\n"
-
-
-	"\nSumidouros do Semáforo 1\n" <<
-
-	"O1oeste { Entraram: " << W1west.entered() <<
-	" Sairam: " 		   << W1west.left() <<
-	" Estão dentro: " 	   << W1west.areIn() << " }\n"
-
-	"N1norte { Entraram: " << N1north.entered() <<
-	" Sairam: " 		   << N1north.left() <<
-	" Estão dentro: " 	   << N1north.areIn() << " }\n"
-
-	"S1s { Entraram: "     << S1south.entered() <<
-	" Sairam: " 		   << S1south.left() <<
-	" Estão dentro: " 	   << S1south.areIn() << " }\n"
-
-
-	"\nSumidouros do Semáforo 2\n" <<
-
-	"N2norte { Entraram: " << N2north.entered() <<
-	" Sairam: " 		   << N2north.left() <<
-	" Estão dentro: " 	   << N2north.areIn() << " }\n"
-
-	"L1leste { Entraram: " << E2east.entered() <<
-	" Sairam: " 		   << E2east.left() <<
-	" Estão dentro: " 	   << E2east.areIn() << " }\n"
-
-	"S2sul { Entraram: "   << S2south.entered() <<
-	" Sairam: " 		   << S2south.left() <<
-	" Estão dentro: " 	   << S2south.areIn() << " }\n\n"
-
-
-	"Entraram: " << Roadway::totalIn() <<
-	" Sairam: " 		 << Roadway::totalOut() <<
-	" Estão dentro: "
-	<< Roadway::totalIn() - Roadway::totalOut() << " }\n"
+	<< "Entraram: " << network.totalIn()
+	<< "\nSaíram: " << network.totalOut()
+	<< "\nPermanecem dentro: " << (network.totalIn() - network.totalOut())
+	<< "\nPico de eventos pendentes: " << simulation.peakEvents();
+	if (synchronization == Simulation::OPTIMISTIC && partitions > 1) {
+		std::cout << "\nEventos desfeitos: " << simulation.eventsRolledBack();
+	}
+	if (steadyWidth > 0 && simulation.warmupEnd() < 0) {
+		std::cout << "\nRegime permanente não atingido até o instante "
+			<< simulation.endTime();
+	} else if (steadyWidth > 0) {
+		Estimate out = simulation.throughput();
+		Estimate inside = simulation.occupancy();
+		std::cout << "\nAquecimento descartado até o instante "
+		<< simulation.warmupEnd()
+		<< "\nParou no instante " << simulation.endTime()
+		<< "\nSaídas por " << steadyBatch << " s: " << out.mean << " +- "
+		<< out.halfWidth
+		<< "\nVeículos dentro: " << inside.mean << " +- " << inside.halfWidth;
+	}
+	std::cout << "\n--------------------\n" << std::endl;
+
+	if (!statsFile.empty()) {
+		std::ofstream stats(statsFile);
+		bool json = statsFile.size() >= 5 &&
+			statsFile.compare(statsFile.size() - 5, 5, ".json") == 0;
+		if (json) {
+			writeStatisticsJson(stats, network, simulation.endTime());
+		} else {
+			writeStatisticsCsv(stats, network, simulation.endTime());
+		}
+		if (!stats) {
+			std::cout << "Não foi possível escrever " << statsFile << "\n";
+		}
+	}
 
-	<< std::endl;
-*/}
 	std::cout << "Fim do programa.\n";
 
 	return 0;